@@ -0,0 +1,75 @@
+#include "action_values.h"
+
+#include <cassert>
+#include <cmath>
+
+using namespace std;
+
+SharedActionValues::SharedActionValues(int num_operators, int weight) {
+    Counts empty;
+    empty.hits = 0;
+    empty.trials = 0;
+    mda_counts.assign(num_operators, empty);
+    mha_counts.assign(num_operators, empty);
+    mha_walks = 0;
+    prior_weight = weight;
+}
+
+void SharedActionValues::add(volatile int &count, int delta) {
+    if(delta != 0)
+        __sync_fetch_and_add(&count, delta);
+}
+
+void SharedActionValues::get_mda_values(vector<double> &q,
+        vector<int> &num) const {
+    for(int i = 0; i < mda_counts.size(); i++) {
+        int hits = mda_counts[i].hits;
+        int trials = mda_counts[i].trials;
+        if(trials <= 0) {
+            q[i] = 0;
+            num[i] = 0;
+            continue;
+        }
+        // the share of the selections that ended in a dead end, which the
+        // walker counts negatively
+        num[i] = trials < prior_weight ? trials : prior_weight;
+        q[i] = -double(hits) / trials * num[i];
+    }
+}
+
+void SharedActionValues::get_mha_values(vector<double> &q) const {
+    int walks = mha_walks;
+    for(int i = 0; i < mha_counts.size(); i++) {
+        if(walks <= 0) {
+            q[i] = 0;
+            continue;
+        }
+        // how often the operator would have been preferred in prior_weight
+        // walks
+        int weight = walks < prior_weight ? walks : prior_weight;
+        q[i] = double(mha_counts[i].hits) / walks * weight;
+    }
+}
+
+void SharedActionValues::add_mda_values(const vector<double> &q,
+        const vector<double> &prior_q, const vector<int> &num,
+        const vector<int> &prior_num) {
+    assert(q.size() == mda_counts.size());
+    for(int i = 0; i < mda_counts.size(); i++) {
+        if(mda_counts[i].trials >= MAX_COUNT)
+            continue;
+        // the walker subtracts one for every dead end walk
+        add(mda_counts[i].hits, int(floor(prior_q[i] - q[i] + 0.5)));
+        add(mda_counts[i].trials, num[i] - prior_num[i]);
+    }
+}
+
+void SharedActionValues::add_mha_values(const vector<double> &q,
+        const vector<double> &prior_q, int walks) {
+    assert(q.size() == mha_counts.size());
+    if(walks == 0 || mha_walks >= MAX_COUNT)
+        return;
+    for(int i = 0; i < mha_counts.size(); i++)
+        add(mha_counts[i].hits, int(floor(q[i] - prior_q[i] + 0.5)));
+    __sync_fetch_and_add(&mha_walks, walks);
+}
@@ -0,0 +1,65 @@
+#ifndef ACTION_VALUES_H
+#define ACTION_VALUES_H
+
+#include <vector>
+
+/**
+ * The action values of MDA and MHA walks, pooled over the walkers of all
+ * MRW threads. Without them a walker starts every step knowing nothing about
+ * which operators tend to lead into dead ends or to be preferred.
+ *
+ * A walker still learns the values of a step on its own. When the step is
+ * over, it adds what it counted to the totals here, and at the start of the
+ * next one it takes the totals as its initial values, weighted as if it had
+ * already selected each operator prior_weight times. The totals are updated
+ * with atomic additions and read without a lock, so a snapshot may mix the
+ * counts of before and after another thread published.
+ *
+ * Every walker publishes once per step, so the arrays are rarely written.
+ * The counts of the two walk types are kept apart, since a step only touches
+ * those of its own type, and the walk counter that all MHA walkers update
+ * has a cache line of its own.
+**/
+class SharedActionValues {
+    // the counts of an operator stop growing once it has been tried this
+    // often, so that they do not overflow. The values hardly change anymore
+    // by then.
+    enum {MAX_COUNT = 1 << 30};
+
+    struct Counts {
+        // MDA: dead end walks that selected the operator, MHA: endpoints
+        // that preferred it
+        volatile int hits;
+        // MDA: selections of the operator
+        volatile int trials;
+    };
+    std::vector<Counts> mda_counts;
+    std::vector<Counts> mha_counts;
+
+    char padding[64];
+    // endpoints of MHA walks
+    volatile int mha_walks;
+    char padding_end[64];
+
+    int prior_weight;
+
+    static void add(volatile int &count, int delta);
+public:
+    SharedActionValues(int num_operators, int prior_weight);
+
+    int get_prior_weight() const {return prior_weight;}
+
+    // initial values of an MDA step, with num the selection counts
+    void get_mda_values(std::vector<double> &q, std::vector<int> &num) const;
+    // initial values of an MHA step
+    void get_mha_values(std::vector<double> &q) const;
+
+    // adds the change of the values since they were taken
+    void add_mda_values(const std::vector<double> &q,
+            const std::vector<double> &prior_q, const std::vector<int> &num,
+            const std::vector<int> &prior_num);
+    void add_mha_values(const std::vector<double> &q,
+            const std::vector<double> &prior_q, int walks);
+};
+
+#endif
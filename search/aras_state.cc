@@ -37,7 +37,7 @@ ArasState::ArasState(istream &in) {
     check_magic(in, "begin_state");
     for(int i = 0; i < g_variable_domain.size(); i++) {
 	int var;
-	cin >> var;
+	in >> var;
 	vars[i] = var;
 	// cout << int(vars[i]) << endl;
     }
@@ -0,0 +1,201 @@
+#include "cg_heuristic.h"
+
+#include "domain_transition_graph.h"
+#include "globals.h"
+#include "operator.h"
+#include "state.h"
+
+#include <cassert>
+#include <climits>
+
+using namespace std;
+
+CGHeuristic::CGHeuristic() {
+    cout << "Initializing causal graph heuristic..." << endl;
+
+    int num_vars = g_variable_domain.size();
+    int table_size = 0, num_nodes = 0, num_child_values = 0;
+    for(int var = 0; var < num_vars; var++) {
+        int range = g_variable_domain[var];
+        int num_children = g_transition_graphs[var]->local_to_global_child.size();
+        table_offset.push_back(table_size);
+        node_offset.push_back(num_nodes);
+        child_offset.push_back(num_child_values);
+        table_size += range * range;
+        num_nodes += range;
+        num_child_values += range * num_children;
+    }
+    distances.resize(table_size);
+    helpful_labels.resize(table_size);
+    computed_in.resize(num_nodes, -1);
+    child_values.resize(num_child_values);
+    marked_in.resize(num_vars, -1);
+    evaluation = 0;
+
+    int max_cost = 0;
+    for(int i = 0; i < g_operators.size(); i++)
+        max_cost = max(max_cost, g_operators[i].get_cost());
+    queues.resize(num_vars);
+    for(int var = 0; var < num_vars; var++)
+        queues[var].set_max_cost(max_cost);
+}
+
+CGHeuristic::~CGHeuristic() {
+}
+
+void CGHeuristic::start_evaluation() {
+    if(evaluation == INT_MAX) {
+        evaluation = 0;
+        computed_in.assign(computed_in.size(), -1);
+        marked_in.assign(marked_in.size(), -1);
+    }
+    evaluation++;
+}
+
+int CGHeuristic::get_transition_cost(const State &state,
+                                     DomainTransitionGraph *dtg,
+                                     int from, int to) {
+    if(from == to)
+        return 0;
+    int var = dtg->var;
+    if(computed_in[node_offset[var] + from] != evaluation)
+        compute_costs_from(state, dtg, from);
+    return distances[table_offset[var] + from * dtg->nodes.size() + to];
+}
+
+void CGHeuristic::compute_costs_from(const State &state,
+                                     DomainTransitionGraph *dtg, int from) {
+    int var = dtg->var;
+    int range = dtg->nodes.size();
+    int num_children = dtg->local_to_global_child.size();
+    int *dist = &distances[table_offset[var] + from * range];
+    const ValueTransitionLabel **helpful =
+        &helpful_labels[table_offset[var] + from * range];
+    int *children = &child_values[child_offset[var]];
+
+    for(int value = 0; value < range; value++) {
+        dist[value] = -1;
+        helpful[value] = 0;
+    }
+    for(int i = 0; i < num_children; i++)
+        children[from * num_children + i] =
+            state[dtg->local_to_global_child[i]];
+    dist[from] = 0;
+
+    // Only lower variables are searched while this search runs, so it does
+    // not share its queue or arrays with them.
+    MonotoneQueue<int> &queue = queues[var];
+    queue.clear();
+    queue.push(0, from);
+    while(!queue.empty()) {
+        pair<int, int> top = queue.pop();
+        int source = top.second;
+        if(top.first > dist[source])
+            continue;
+        const int *source_children = &children[source * num_children];
+
+        const vector<ValueTransition> &transitions =
+            dtg->nodes[source].transitions;
+        for(int i = 0; i < transitions.size(); i++) {
+            int target = transitions[i].target->value;
+            const vector<ValueTransitionLabel> &labels = transitions[i].labels;
+            for(int j = 0; j < labels.size(); j++) {
+                const ValueTransitionLabel &label = labels[j];
+                int cost = dtg->is_axiom ? 0 : label.op->get_cost();
+                for(int k = 0; k < label.prevail.size() && cost != -1; k++) {
+                    const PrevailCondition &prev = label.prevail[k];
+                    int prev_cost = get_transition_cost(state, prev.prev_dtg,
+                            source_children[prev.local_var], prev.value);
+                    cost = prev_cost == -1 ? -1 : cost + prev_cost;
+                }
+                if(cost == -1)
+                    continue;
+
+                int target_dist = top.first + cost;
+                if(dist[target] != -1 && dist[target] <= target_dist)
+                    continue;
+                dist[target] = target_dist;
+                helpful[target] = source == from ? &label : helpful[source];
+                int *target_children = &children[target * num_children];
+                for(int k = 0; k < num_children; k++)
+                    target_children[k] = source_children[k];
+                for(int k = 0; k < label.prevail.size(); k++)
+                    target_children[label.prevail[k].local_var] =
+                        label.prevail[k].value;
+                queue.push(target_dist, target);
+            }
+        }
+    }
+    computed_in[node_offset[var] + from] = evaluation;
+}
+
+void CGHeuristic::mark_helpful_transitions(const State &state,
+                                           DomainTransitionGraph *dtg,
+                                           int to) {
+    int var = dtg->var;
+    int from = state[var];
+    if(from == to || marked_in[var] == evaluation)
+        return;
+    // the costs from the current value of every variable that this is
+    // called for were needed for the heuristic value
+    assert(computed_in[node_offset[var] + from] == evaluation);
+    const ValueTransitionLabel *label =
+        helpful_labels[table_offset[var] + from * dtg->nodes.size() + to];
+    if(label == 0)
+        return;
+    marked_in[var] = evaluation;
+
+    // A transition whose prevail conditions hold is helpful if it can be
+    // taken right away, otherwise the transitions that bring about its
+    // prevail conditions may be.
+    bool prevails_hold = true;
+    for(int i = 0; i < label->prevail.size(); i++) {
+        const PrevailCondition &prev = label->prevail[i];
+        int prev_var = prev.prev_dtg->var;
+        if(state[prev_var] != prev.value) {
+            prevails_hold = false;
+            mark_helpful_transitions(state, prev.prev_dtg, prev.value);
+        }
+    }
+    if(!prevails_hold || dtg->is_axiom)
+        return;
+    // The label leaves out the conditions that the causal graph cycles were
+    // broken at, so those of the operator are checked. This is done here
+    // rather than by Operator::is_applicable, which prints the first
+    // precondition that does not hold.
+    const vector<Prevail> &prevail = label->op->get_prevail();
+    for(int i = 0; i < prevail.size(); i++)
+        if(!prevail[i].is_applicable(state))
+            return;
+    const vector<PrePost> &pre_post = label->op->get_pre_post();
+    for(int i = 0; i < pre_post.size(); i++)
+        if(!pre_post[i].is_applicable(state))
+            return;
+    set_preferred(label->op);
+}
+
+int CGHeuristic::compute_heuristic(const State &state) {
+    // Each node of a domain transition graph only keeps the values of the
+    // prevail variables on the cheapest path to it, so a goal that cannot
+    // be reached in this way may still be reachable. This is why dead ends
+    // are not reliable.
+    start_evaluation();
+    int h = 0;
+    for(int i = 0; i < g_goal.size(); i++) {
+        int var = g_goal[i].first;
+        int cost = get_transition_cost(state, g_transition_graphs[var],
+                state[var], g_goal[i].second);
+        if(cost == -1)
+            return DEAD_END;
+        h += cost;
+        if(h > get_cutoff())
+            return PRUNED;
+    }
+
+    for(int i = 0; i < g_goal.size(); i++) {
+        int var = g_goal[i].first;
+        mark_helpful_transitions(state, g_transition_graphs[var],
+                g_goal[i].second);
+    }
+    return h;
+}
@@ -0,0 +1,69 @@
+#ifndef CG_HEURISTIC_H
+#define CG_HEURISTIC_H
+
+#include "heuristic.h"
+#include "priority_queues.h"
+
+#include <vector>
+
+class DomainTransitionGraph;
+class State;
+struct ValueTransitionLabel;
+
+/**
+ * The causal graph heuristic. The cost of changing a variable from one
+ * value to another is the cost of the cheapest path in its domain transition
+ * graph, where each transition also pays for bringing the variables in its
+ * prevail conditions to the required values, and the heuristic value is the
+ * sum of these costs for the goals. Prevail conditions on higher variables
+ * are ignored, which breaks the cycles of the causal graph.
+ *
+ * The distances from a value are computed by a Dijkstra search in the
+ * domain transition graph the first time they are needed in an evaluation
+ * and are then reused for the rest of it. The graphs are shared between
+ * threads, so all data of the computation is kept here, in flat arrays.
+**/
+class CGHeuristic : public Heuristic {
+    // the cost tables of variable var start at table_offset[var], with the
+    // costs from value from at table_offset[var] + from * domain size
+    std::vector<int> table_offset;
+    std::vector<int> distances;        // -1 if the value cannot be reached
+    // first transition on the cheapest path, 0 if there is none
+    std::vector<const ValueTransitionLabel *> helpful_labels;
+
+    // node_offset[var] + value is the index of the value in the arrays below
+    std::vector<int> node_offset;
+    // evaluation in which the costs from the value were computed
+    std::vector<int> computed_in;
+    // values of the variables in the prevail conditions of the transitions
+    // from the value, on the cheapest path found so far. The values of
+    // variable var start at child_offset[var].
+    std::vector<int> child_offset;
+    std::vector<int> child_values;
+
+    // one queue per variable, since computing the costs of a variable needs
+    // those of lower variables in turn
+    std::vector<MonotoneQueue<int> > queues;
+
+    // evaluation in which a helpful transition of the variable was marked
+    std::vector<int> marked_in;
+    int evaluation;
+
+    int get_transition_cost(const State &state, DomainTransitionGraph *dtg,
+                            int from, int to);
+    void compute_costs_from(const State &state, DomainTransitionGraph *dtg,
+                            int from);
+    void mark_helpful_transitions(const State &state,
+                                  DomainTransitionGraph *dtg, int to);
+    void start_evaluation();
+protected:
+    virtual int compute_heuristic(const State &state);
+public:
+    CGHeuristic();
+    ~CGHeuristic();
+
+    virtual bool dead_ends_are_reliable() {return false;}
+    virtual std::string get_heuristic_name() {return "CG";}
+};
+
+#endif
@@ -1,6 +1,8 @@
 #include "command_line_parsing.h"
 #include "globals.h"
 #include "successor_generator.h"
+#include "heuristic_cache.h"
+#include "pdb_heuristic.h"
 #include <iostream>
 #include <fstream>
 
@@ -100,6 +102,7 @@ bool process_command_line(int argc, const char *argv[],
         output_help_information();
         return false;
     }
+    bool seed_entered = false;
     // loop over args
     for(int i = 1; i < argc; ++i) {
         string arg = string(argv[i]);
@@ -116,6 +119,10 @@ bool process_command_line(int argc, const char *argv[],
 	    } else if(arg.compare("-g") == 0) {
             i++;
             g_all_groups_file = string(argv[i]);
+        // landmarks graph cache
+        } else if(arg.compare("-lm_cache") == 0) {
+            i++;
+            g_lm_cache_file = string(argv[i]);
         // entering a lama configuration
         } else if(arg.compare("-wa_conf") == 0) {
             i++;
@@ -190,16 +197,63 @@ bool process_command_line(int argc, const char *argv[],
 
         // entering a random seed
         } else if(arg.compare("-seed") == 0) {
+            if(seed_entered) {
+                cerr << "Cannot enter -seed multiple times." << endl;
+                return false;
+            }
             i++;
-            int seed = atoi(argv[i]);
-
-            g_seed_list.push_back(seed);
+            g_seed = atoi(argv[i]);
+            seed_entered = true;
         } else if(arg.compare("-iterative") == 0) {
         	if(g_iterative) {
         		cerr << "Cannot enter -iterative multiple times." << endl;
         		return false;
         	}
         	g_iterative = true;
+        } else if(arg.compare("-h_cache") == 0) {
+            i++;
+            if(g_h_cache_kb != -1) {
+                cerr << "Cannot set the heuristic cache size multiple times"
+                    << endl;
+                return false;
+            } else if(!string_to_int(argv[i], g_h_cache_kb))
+                return false;
+
+            if(g_h_cache_kb < 1) {
+                cerr << "-h_cache must be in the range [1,infty)" << endl;
+                return false;
+            }
+        } else if(arg.compare("-h_cache_policy") == 0) {
+            i++;
+            if(!HeuristicCache::policy_from_string(argv[i], g_h_cache_policy))
+                return false;
+        } else if(arg.compare("-pdb_kb") == 0) {
+            i++;
+            if(g_pdb_kb != -1) {
+                cerr << "Cannot set the pattern database size multiple times"
+                    << endl;
+                return false;
+            } else if(!string_to_int(argv[i], g_pdb_kb))
+                return false;
+
+            if(g_pdb_kb < 1) {
+                cerr << "-pdb_kb must be in the range [1,infty)" << endl;
+                return false;
+            }
+        } else if(arg.compare("-dead_end_store") == 0) {
+            i++;
+            if(g_dead_end_store_kb != -1) {
+                cerr << "Cannot set the dead-end store size multiple times"
+                    << endl;
+                return false;
+            } else if(!string_to_int(argv[i], g_dead_end_store_kb))
+                return false;
+
+            if(g_dead_end_store_kb < 1) {
+                cerr << "-dead_end_store must be in the range [1,infty)"
+                    << endl;
+                return false;
+            }
         } else {
             // invalid entry
             cerr << "unknown option:" << argv[i] << " entered" << endl;
@@ -207,9 +261,9 @@ bool process_command_line(int argc, const char *argv[],
         }
     }
 
-    if(g_seed_list.size() == 0)
-    	g_seed_list.push_back(time(NULL));
-    srandom(g_seed_list[0]);
+    if(!seed_entered)
+    	g_seed = time(NULL);
+    srandom(g_seed);
 
     return true;
 }
@@ -276,6 +330,18 @@ void output_help_information() {
     cerr << "options can include the following: " << endl;
     cerr << "\t-seed n : random number seed set to n" << endl;
     cerr << "\t-iterative : keep searching after first solution is found." << endl;
+    cerr << "\t-h_cache n : shares heuristic values between all searches " <<
+        "in a table\n\t\tof n KB. Not used by default" << endl;
+    cerr << "\t-h_cache_policy ALWAYS|HIGH_H : replacement policy of the " <<
+        "heuristic\n\t\tcache. HIGH_H evicts the entry with the higher " <<
+        "value and is the default" << endl;
+    cerr << "\t-dead_end_store n : learns dead ends and shares them between " <<
+        "all searches\n\t\tin a store of n KB. Not used by default" << endl;
+    cerr << "\t-pdb_kb n : limits the pattern databases of the PDB heuristic "
+        << "to n KB.\n\t\t" << PDBCollection::DEFAULT_KB << " by default" << endl;
+    cerr << "\t-lm_cache FILE : loads the landmarks graph from FILE if it " <<
+        "was saved for\n\t\tthe same task and groups file, and saves it " <<
+        "there otherwise.\n\t\tNot used by default" << endl;
     cerr << "\t-mrw_conf \"CONF\" : entering a MRW configuration " <<
         "(see below)" << endl;
     cerr << "\t-mrw_shared \"CONF\" : entering a shared mrw configuration " 
@@ -310,6 +376,9 @@ void output_heuristic_information() {
         " in FD" << endl;
     cerr << "\tBLIND: 0 for goals and 1 everywhere else" << endl;
     cerr << "\tGOAL_COUNT: goal count heuristic" << endl;
+    cerr << "\tCG: causal graph heuristic" << endl;
+    cerr << "\tPDB: sum of pattern databases for disjoint patterns of " <<
+        "causally\n\t\trelated variables. Only for MRW" << endl;
     cerr << "\tFF_SWITCH: " << endl;
     cerr << "\t\t- Uses FF_S for GBFS or if non-metric, FF_C for WA*, stores both" << endl;
     cerr << "\tFD_SWITCH: " << endl;
@@ -320,15 +389,36 @@ void output_heuristic_information() {
 void output_shared_param_values() {
 	cout << "Main Planner Parameters " << endl;
 
-	cout << "\tseeds:" << endl;
-	for(int i = 0; i < g_seed_list.size(); i++) {
-		cout << "\t\t" << g_seed_list[i] << endl;
-	}
+	cout << "\tseed: " << g_seed << endl;
 	cout << "\tIterative Search: ";
 	if(g_iterative)
 		cout << "True" << endl;
 	else
 		cout << "False" << endl;
 
+	cout << "\tHeuristic Cache: ";
+	if(g_h_cache_kb == -1)
+		cout << "None" << endl;
+	else
+		cout << g_h_cache_kb << " KB, replacing "
+			<< HeuristicCache::policy_to_string(g_h_cache_policy) << endl;
+
+	cout << "\tDead-End Store: ";
+	if(g_dead_end_store_kb == -1)
+		cout << "None" << endl;
+	else
+		cout << g_dead_end_store_kb << " KB" << endl;
+
+	cout << "\tPattern Databases: ";
+	if(g_pdb_kb == -1)
+		cout << PDBCollection::DEFAULT_KB << " KB" << endl;
+	else
+		cout << g_pdb_kb << " KB" << endl;
+
+	cout << "\tLandmarks Graph Cache: ";
+	if(g_lm_cache_file.empty())
+		cout << "None" << endl;
+	else
+		cout << g_lm_cache_file << endl;
 }
 
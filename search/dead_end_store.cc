@@ -0,0 +1,275 @@
+#include "dead_end_store.h"
+
+#include "globals.h"
+#include "operator.h"
+#include "state.h"
+
+#include <cassert>
+#include <cstdlib>
+
+using namespace std;
+
+DeadEndStore::DeadEndStore(int size_kb) {
+    arena_size = (size_kb * 1024) / sizeof(int);
+    arena = new int[arena_size];
+    arena_used = 0;
+    num_nogoods = 0;
+
+    build_relaxed_task();
+
+    index_heads = new int[fact_var.size()];
+    for(int i = 0; i < fact_var.size(); i++)
+        index_heads[i] = -1;
+}
+
+DeadEndStore::~DeadEndStore() {
+    delete[] arena;
+    delete[] index_heads;
+}
+
+void DeadEndStore::build_relaxed_task() {
+    for(int var = 0; var < g_variable_domain.size(); var++) {
+        fact_offset.push_back(fact_var.size());
+        for(int val = 0; val < g_variable_domain[var]; val++)
+            fact_var.push_back(var);
+    }
+
+    for(int i = 0; i < g_operators.size(); i++)
+        for(int j = 0; j < g_operators[i].get_pre_post().size(); j++)
+            add_unary_operator(g_operators[i], j);
+    for(int i = 0; i < g_axioms.size(); i++)
+        for(int j = 0; j < g_axioms[i].get_pre_post().size(); j++)
+            add_unary_operator(g_axioms[i], j);
+    unary_pre_start.push_back(unary_pre.size());
+
+    achievers.resize(fact_var.size());
+    precondition_of.resize(fact_var.size());
+    for(int op = 0; op < unary_effect.size(); op++) {
+        achievers[unary_effect[op]].push_back(op);
+        for(int i = unary_pre_start[op]; i < unary_pre_start[op + 1]; i++)
+            precondition_of[unary_pre[i]].push_back(op);
+    }
+}
+
+void DeadEndStore::add_unary_operator(const Operator &op, int effect) {
+    const vector<Prevail> &prevail = op.get_prevail();
+    const vector<PrePost> &pre_post = op.get_pre_post();
+
+    unary_pre_start.push_back(unary_pre.size());
+    for(int i = 0; i < prevail.size(); i++)
+        unary_pre.push_back(get_fact(prevail[i].var, prevail[i].prev));
+
+    // the old value of a derived variable does not restrict an axiom, leaving
+    // it out only makes the relaxation weaker
+    if(!op.is_axiom()) {
+        for(int i = 0; i < pre_post.size(); i++)
+            if(pre_post[i].pre != -1)
+                unary_pre.push_back(get_fact(pre_post[i].var, pre_post[i].pre));
+    }
+    const vector<Prevail> &cond = pre_post[effect].cond;
+    for(int i = 0; i < cond.size(); i++)
+        unary_pre.push_back(get_fact(cond[i].var, cond[i].prev));
+
+    unary_effect.push_back(get_fact(pre_post[effect].var,
+            pre_post[effect].post));
+}
+
+int DeadEndStore::allocate(int num_ints) {
+    if(arena_used >= arena_size)
+        return -1;
+    int offset = __sync_fetch_and_add(&arena_used, num_ints);
+    if(offset + num_ints > arena_size)
+        return -1;
+    return offset;
+}
+
+bool DeadEndStore::add_nogood(const vector<pair<int, int> > &nogood) {
+    int size = nogood.size();
+    assert(size > 0);
+
+    int offset = allocate(1 + 4 * size);
+    if(offset == -1)
+        return false;
+
+    arena[offset] = size;
+    for(int i = 0; i < size; i++) {
+        arena[offset + 1 + 2 * i] = nogood[i].first;
+        arena[offset + 2 + 2 * i] = nogood[i].second;
+    }
+
+    // publish the nogood in the list of each of its facts. The nogood is
+    // fully written before the compare-and-swap makes it visible.
+    for(int i = 0; i < size; i++) {
+        int node = offset + 1 + 2 * size + 2 * i;
+        int fact = get_fact(nogood[i].first, nogood[i].second);
+        arena[node] = offset;
+        int old_head;
+        do {
+            old_head = index_heads[fact];
+            arena[node + 1] = old_head;
+        } while(!__sync_bool_compare_and_swap(&index_heads[fact], old_head,
+                node));
+    }
+    __sync_fetch_and_add(&num_nogoods, 1);
+    return true;
+}
+
+bool DeadEndStore::leads_to_dead_end(const State &state,
+        const Operator &op) const {
+
+    const vector<PrePost> &pre_post = op.get_pre_post();
+    for(int i = 0; i < pre_post.size(); i++) {
+        const PrePost &effect = pre_post[i];
+
+        // derived variables are never part of a nogood
+        if(g_axiom_layers[effect.var] != -1 || state[effect.var] == effect.post
+                || !effect.does_fire(state))
+            continue;
+
+        int node = index_heads[get_fact(effect.var, effect.post)];
+        for(; node != -1; node = arena[node + 1]) {
+            int offset = arena[node];
+            int size = arena[offset];
+
+            bool matches = true;
+            for(int j = 0; j < size && matches; j++) {
+                int var = arena[offset + 1 + 2 * j];
+                int value = state[var];
+                for(int k = 0; k < pre_post.size(); k++)
+                    if(pre_post[k].var == var && pre_post[k].does_fire(state))
+                        value = pre_post[k].post;
+                matches = (value == arena[offset + 2 + 2 * j]);
+            }
+            if(matches)
+                return true;
+        }
+    }
+    return false;
+}
+
+DeadEndLearner::DeadEndLearner(DeadEndStore *s) : store(s) {
+    reached.resize(store->fact_var.size(), false);
+    in_explanation.resize(store->fact_var.size(), false);
+    unsatisfied.resize(store->unary_effect.size());
+    var_in_nogood.resize(g_variable_domain.size(), false);
+    num_learned = 0;
+    num_attempts = 0;
+}
+
+void DeadEndLearner::compute_reachability(const State &state) {
+    for(int i = 0; i < reached.size(); i++)
+        reached[i] = false;
+    queue.clear();
+
+    for(int var = 0; var < g_variable_domain.size(); var++) {
+        int fact = store->get_fact(var, state[var]);
+        reached[fact] = true;
+        queue.push_back(fact);
+    }
+    for(int op = 0; op < unsatisfied.size(); op++) {
+        unsatisfied[op] = store->unary_pre_start[op + 1] -
+                store->unary_pre_start[op];
+        int effect = store->unary_effect[op];
+        if(unsatisfied[op] == 0 && !reached[effect]) {
+            reached[effect] = true;
+            queue.push_back(effect);
+        }
+    }
+
+    for(int head = 0; head < queue.size(); head++) {
+        const vector<int> &ops = store->precondition_of[queue[head]];
+        for(int i = 0; i < ops.size(); i++) {
+            if(--unsatisfied[ops[i]] == 0) {
+                int effect = store->unary_effect[ops[i]];
+                if(!reached[effect]) {
+                    reached[effect] = true;
+                    queue.push_back(effect);
+                }
+            }
+        }
+    }
+}
+
+int DeadEndLearner::get_unreachable_goal() const {
+    for(int i = 0; i < g_goal.size(); i++) {
+        int fact = store->get_fact(g_goal[i].first, g_goal[i].second);
+        if(!reached[fact])
+            return fact;
+    }
+    return -1;
+}
+
+bool DeadEndLearner::explain(const State &state, int goal_fact) {
+    explanation.clear();
+    nogood.clear();
+
+    bool explained = true;
+    in_explanation[goal_fact] = true;
+    explanation.push_back(goal_fact);
+    for(int next = 0; next < explanation.size() && explained; next++) {
+        int fact = explanation[next];
+        int var = store->fact_var[fact];
+
+        if(g_axiom_layers[var] != -1) {
+            // a derived variable may take its default value without any
+            // axiom firing, so such facts cannot be explained
+            if(fact - store->fact_offset[var] == g_default_axiom_values[var]) {
+                explained = false;
+                break;
+            }
+        } else if(!var_in_nogood[var]) {
+            var_in_nogood[var] = true;
+            nogood.push_back(make_pair(var, state[var]));
+        }
+
+        // block every achiever by one of its unreachable preconditions,
+        // preferring facts that are already part of the explanation and
+        // then facts whose variable is already in the nogood
+        const vector<int> &ops = store->achievers[fact];
+        for(int i = 0; i < ops.size(); i++) {
+            int start = store->unary_pre_start[ops[i]];
+            int end = store->unary_pre_start[ops[i] + 1];
+            int chosen = -1;
+            for(int j = start; j < end && chosen == -1; j++)
+                if(in_explanation[store->unary_pre[j]])
+                    chosen = store->unary_pre[j];
+            if(chosen != -1)
+                continue;
+            for(int j = start; j < end; j++) {
+                int pre = store->unary_pre[j];
+                if(reached[pre])
+                    continue;
+                if(chosen == -1 || var_in_nogood[store->fact_var[pre]])
+                    chosen = pre;
+            }
+            assert(chosen != -1);
+            in_explanation[chosen] = true;
+            explanation.push_back(chosen);
+        }
+    }
+
+    for(int i = 0; i < explanation.size(); i++)
+        in_explanation[explanation[i]] = false;
+    for(int i = 0; i < nogood.size(); i++)
+        var_in_nogood[nogood[i].first] = false;
+    return explained && !nogood.empty();
+}
+
+bool DeadEndLearner::learn(const State &state) {
+    if(store->is_full())
+        return false;
+    num_attempts++;
+
+    compute_reachability(state);
+    int goal_fact = get_unreachable_goal();
+    if(goal_fact == -1)
+        return false;
+
+    if(!explain(state, goal_fact))
+        return false;
+
+    if(!store->add_nogood(nogood))
+        return false;
+    num_learned++;
+    return true;
+}
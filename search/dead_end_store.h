@@ -0,0 +1,115 @@
+#ifndef DEAD_END_STORE_H
+#define DEAD_END_STORE_H
+
+#include <vector>
+
+class State;
+class Operator;
+
+/**
+ * A store of learned dead ends that is shared by all search threads.
+ *
+ * A dead end is stored as a nogood: a partial assignment such that every
+ * state agreeing with it is unsolvable. Nogoods are written into a
+ * fixed-size arena and indexed by each of their facts with lock-free
+ * linked lists, so they can be added and queried without locks. Nothing
+ * is ever removed; once the arena is full no further nogoods are learned.
+**/
+class DeadEndStore {
+    friend class DeadEndLearner;
+
+    // arena holding nogoods as [size, var, val, var, val, ...] and index
+    // nodes as [nogood offset, next node]
+    int *arena;
+    int arena_size;
+    volatile int arena_used;
+
+    // first index node of every fact, -1 for an empty list
+    volatile int *index_heads;
+
+    volatile int num_nogoods;
+
+    // relaxed task used to learn nogoods. Facts are numbered by
+    // fact_offset[var] + val. Every unary operator has one effect of an
+    // operator or axiom, with the conditions of that effect added to the
+    // preconditions of the operator.
+    std::vector<int> fact_offset;
+    std::vector<int> fact_var;
+    std::vector<int> unary_pre_start;
+    std::vector<int> unary_pre;
+    std::vector<int> unary_effect;
+    std::vector<std::vector<int> > achievers;
+    std::vector<std::vector<int> > precondition_of;
+
+    void build_relaxed_task();
+    void add_unary_operator(const Operator &op, int effect);
+
+    int get_fact(int var, int val) const {return fact_offset[var] + val;}
+    int allocate(int num_ints);
+
+public:
+    DeadEndStore(int size_kb);
+    ~DeadEndStore();
+
+    /**
+     * Adds the nogood given by the (var, val) pairs. Returns false if the
+     * arena is full.
+    **/
+    bool add_nogood(const std::vector<std::pair<int, int> > &nogood);
+
+    /**
+     * Returns true if applying op in state leads into a state that matches
+     * a stored nogood. Only nogoods containing a fact that op newly makes
+     * true are looked at, as the others cannot be completed by op.
+    **/
+    bool leads_to_dead_end(const State &state, const Operator &op) const;
+
+    int get_num_nogoods() const {return num_nogoods;}
+    bool is_full() const {return arena_used >= arena_size;}
+};
+
+/**
+ * Learns nogoods from dead-end states and adds them to a DeadEndStore.
+ * Holds the scratch space of the relaxed exploration, so every thread
+ * needs its own learner.
+ *
+ * A state s is only learned from if some goal is unreachable from s in the
+ * delete relaxation. The learner then collects a set F of relaxed
+ * unreachable facts containing that goal, such that every achiever of a
+ * fact in F has a precondition in F. No fact of F can become true from any
+ * state in which all facts of F are false, so the values that s assigns to
+ * the non-derived variables of F form a nogood. Landmark dead ends depend
+ * on the path to the state and are not generalised.
+**/
+class DeadEndLearner {
+    DeadEndStore *store;
+
+    std::vector<char> reached;
+    std::vector<int> unsatisfied;
+    std::vector<int> queue;
+    std::vector<char> in_explanation;
+    std::vector<char> var_in_nogood;
+    std::vector<int> explanation;
+    std::vector<std::pair<int, int> > nogood;
+
+    int num_learned;
+    int num_attempts;
+
+    void compute_reachability(const State &state);
+    int get_unreachable_goal() const;
+    bool explain(const State &state, int goal_fact);
+
+public:
+    DeadEndLearner(DeadEndStore *s);
+
+    /**
+     * Tries to generalise the dead end state into a nogood and store it.
+     * Returns true if a nogood was stored.
+    **/
+    bool learn(const State &state);
+
+    int get_num_learned() const {return num_learned;}
+    int get_num_attempts() const {return num_attempts;}
+};
+
+#endif
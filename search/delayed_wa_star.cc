@@ -30,6 +30,7 @@
 #include "ff_heuristic.h"
 #include "landmarks_count_heuristic.h"
 #include "memory_utils.h"
+#include "dead_end_store.h"
 
 #include <cassert>
 #define RAND_H_RANGE 0
@@ -48,7 +49,7 @@ OpenListDelayedEntry::OpenListDelayedEntry(const State *_parent,
 	op = _op;
 }
 
-DelayedWAStar::DelayedWAStar(AxiomEvaluator *a, int s_num, MTRand_int32 *rg,
+DelayedWAStar::DelayedWAStar(AxiomEvaluator *a, int s_num, RandomStream *rg,
 		int w, string n, bool ignore, bool r, double eps) :
 	axiom_eval(a), current_state(*g_initial_state), rand_gen(rg),
 	name(n), epsilon(eps) {
@@ -56,6 +57,7 @@ DelayedWAStar::DelayedWAStar(AxiomEvaluator *a, int s_num, MTRand_int32 *rg,
 	generated_states = 0;
 	current_predecessor = 0;
 	current_operator = 0;
+	current_ops_generated = false;
 
     kb_limit = -1.0;
     expansion_limit = -1;
@@ -76,12 +78,28 @@ DelayedWAStar::DelayedWAStar(AxiomEvaluator *a, int s_num, MTRand_int32 *rg,
 
     use_local_bound = false;
     local_bound = -1;
+    follow_shared_bound = false;
+    bound_epoch = 0;
+
+    dead_end_learner = 0;
+    if(g_dead_end_store != NULL)
+        dead_end_learner = new DeadEndLearner(g_dead_end_store);
+    dead_end_pruned = 0;
+}
+
+DelayedWAStar::~DelayedWAStar() {
+    delete dead_end_learner;
 }
 
-DelayedWAStar::~DelayedWAStar() {}
+void DelayedWAStar::set_follow_shared_bound() {
+    follow_shared_bound = true;
+    bound_epoch = g_solution_bound.get_epoch();
+}
 
 void DelayedWAStar::add_heuristic(Heuristic *heuristic, bool use_estimates, bool use_preferred_operators) {
 	heuristics.push_back(heuristic);
+	if (g_heuristic_cache != NULL && heuristic->is_worth_caching())
+		heuristic->set_cache(g_heuristic_cache);
 	cout << "Adding Heuristic: " << heuristic->get_heuristic_name();
 	
 	best_heuristic_values.push_back(-1);
@@ -127,7 +145,12 @@ void DelayedWAStar::statistics() const {
     		dead_end_count << " state(s)." << endl;
 	cout << name << "Total closed list size is " << g_closed_list.size() <<
 			" state(s)." << endl;
-	
+	for (int i = 0; i < heuristics.size(); i++)
+		heuristics[i]->print_cache_statistics(name);
+	if (dead_end_learner != 0)
+		cout << name << "Learned " << dead_end_learner->get_num_learned() <<
+			" dead end(s), pruned " << dead_end_pruned << " successor(s)" <<
+			endl;
 }
 
 bool DelayedWAStar::expand_closed_node(const State *parent_ptr) {
@@ -151,21 +174,31 @@ bool DelayedWAStar::expand_closed_node(const State *parent_ptr) {
 // - current_operator is the operator which leads to current_state from predecessor.
 int DelayedWAStar::step() {
 
+	current_ops_generated = false;
+
 	// Return if some other thread found a solution and shouldn't
 	// keep going
-	if(!g_iterative && g_best_sol_cost != -1)
+	if(g_solution_bound.is_cancelled())
 		return SOLVED;
 
+	if(follow_shared_bound && g_solution_bound.get_epoch() != bound_epoch) {
+		bound_epoch = g_solution_bound.get_epoch();
+		int cost = g_solution_bound.get_cost();
+		if(local_bound == -1 || cost < local_bound)
+			local_bound = cost;
+	}
+
 	// Evaluate only if g-cost of state is lower than bound
 	if(use_local_bound && local_bound != -1) {
 		if(ignore_costs && current_state.get_depth() >= local_bound)
 			return fetch_next_state();
 		else if(!ignore_costs && current_state.get_g_value() >= local_bound)
 			return fetch_next_state();
-	} else if(!use_local_bound && g_best_sol_cost != -1) {
-		if(ignore_costs && current_state.get_depth() >= g_best_sol_cost)
+	} else if(!use_local_bound && g_solution_bound.get_cost() != -1) {
+		int bound = g_solution_bound.get_cost();
+		if(ignore_costs && current_state.get_depth() >= bound)
 			return fetch_next_state();
-		else if(!ignore_costs && current_state.get_g_value() >= g_best_sol_cost)
+		else if(!ignore_costs && current_state.get_g_value() >= bound)
 			return fetch_next_state();
 	}
     
@@ -348,13 +381,17 @@ void DelayedWAStar::reward_progress() {
 }
 
 void DelayedWAStar::calculate_heuristics_and_store() {
+    // generated once and shared by the heuristics and generate_successors
+    current_ops.clear();
+    g_successor_generator->generate_applicable_ops(current_state, current_ops);
+    current_ops_generated = true;
     
     for (int i = 0; i < heuristics.size(); i++) {
         heuristics[i]->set_recompute_heuristic(current_state);
     }
     
     for (int i = 0; i < heuristics.size(); i++) {
-		heuristics[i]->evaluate(current_state);
+		heuristics[i]->evaluate(current_state, &current_ops);
 	    
         if (!heuristics[i]->is_dead_end()) {
             current_state.add_heuristic_value(heuristics[i]->get_heuristic_name(), 
@@ -365,8 +402,11 @@ void DelayedWAStar::calculate_heuristics_and_store() {
             current_state.add_heuristic_value(heuristics[i]->get_heuristic_name(), 
                 Heuristic::DEAD_END);
             
-            if (heuristics[i]->dead_ends_are_reliable())
+            if (heuristics[i]->dead_ends_are_reliable()) {
+                if (dead_end_learner != 0 && !current_state.is_dead_end())
+                    dead_end_learner->learn(current_state);
                 current_state.record_as_dead_end();
+            }
         
         }       
     }
@@ -402,8 +442,16 @@ void DelayedWAStar::get_preferred_from_closed_list(const State *state_ptr) {
 }
 
 void DelayedWAStar::generate_successors(const State *parent_ptr) {
-	vector<const Operator *> all_operators;
-	g_successor_generator->generate_applicable_ops(current_state, all_operators);
+	if (!current_ops_generated) {
+		current_ops.clear();
+		g_successor_generator->generate_applicable_ops(current_state, current_ops);
+	}
+	current_ops_generated = false;
+	vector<const Operator *> &all_operators = current_ops;
+	if (dead_end_learner != 0) {
+		dead_end_pruned += prune_dead_end_successors(all_operators);
+		prune_dead_end_successors(g_preferred_operators);
+	}
     
     int parent_g = parent_ptr->get_g_value();
     int depth = parent_ptr->get_depth() + 1;
@@ -419,7 +467,7 @@ void DelayedWAStar::generate_successors(const State *parent_ptr) {
             
             if(rand_open && ops.size() > 1) {
                 for(unsigned j = 0; j < ops.size() - 1; j++) {
-                    unsigned index = rand_gen->get_32bit_int() % (ops.size() - j);
+                    unsigned index = rand_gen->get_bounded(ops.size() - j);
                     const Operator *to_move = ops[j];
                     ops[j] = ops[index + j];
                     ops[index + j] = to_move;
@@ -431,7 +479,7 @@ void DelayedWAStar::generate_successors(const State *parent_ptr) {
 			    int my_h = h;
 			    
 			    if(RAND_H_RANGE)
-			        my_h += (rand_gen->get_32bit_int() % (2*RAND_H_RANGE + 1)) 
+			        my_h += int(rand_gen->get_bounded(2*RAND_H_RANGE + 1))
 			                - RAND_H_RANGE;
 			    
 			    int my_cost;
@@ -460,6 +508,17 @@ void DelayedWAStar::generate_successors(const State *parent_ptr) {
 	generated_states += all_operators.size();
 }
 
+int DelayedWAStar::prune_dead_end_successors(vector<const Operator *> &ops) {
+	int kept = 0;
+	for (int i = 0; i < ops.size(); i++) {
+		if (!g_dead_end_store->leads_to_dead_end(current_state, *ops[i]))
+			ops[kept++] = ops[i];
+	}
+	int pruned = ops.size() - kept;
+	ops.resize(kept);
+	return pruned;
+}
+
 int DelayedWAStar::fetch_next_state() {
 	OpenListDelayedInfo *open_info = select_open_queue();
 	if (!open_info) {
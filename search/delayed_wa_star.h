@@ -28,12 +28,13 @@
 #include "open_list.h"
 #include "search_engine.h"
 #include "state.h"
-#include "mtrand.h"
+#include "random_stream.h"
 
 #define GBFS -1
 
 class Heuristic;
 class Operator;
+class DeadEndLearner;
 
 struct OpenListDelayedEntry {
 	OpenListDelayedEntry(){}
@@ -74,15 +75,27 @@ protected:
     int expanded_states; // states expanded on this iteration
     int dead_end_count; // counts number of dead ends
 
+    // learns dead ends into g_dead_end_store, NULL if no store is used
+    DeadEndLearner *dead_end_learner;
+    int dead_end_pruned; // successors pruned as known dead ends
+
     AxiomEvaluator *axiom_eval;
 
     State current_state; // current state being considered
     
     const State *current_predecessor; // needed for state fetching
     const Operator *current_operator;
+
+    // applicable operators of current_state if current_ops_generated
+    vector<const Operator *> current_ops;
+    bool current_ops_generated;
     
     int local_bound;
     bool use_local_bound;
+    // whether the local bound is lowered to the plans of other threads,
+    // and the epoch of g_solution_bound it was last compared to
+    bool follow_shared_bound;
+    int bound_epoch;
 
     // checks if the given state is a goal. Assumes that the heuristics have 
     // been calculated and stored in the state
@@ -100,6 +113,10 @@ protected:
     
     // generates succesors for given state pointer
     virtual void generate_successors(const State *parent_ptr);
+
+    // removes the operators leading into a known dead end of current_state
+    // and returns how many were removed
+    int prune_dead_end_successors(vector<const Operator *> &ops);
     
     // gets the next state from an open list
     virtual int fetch_next_state();
@@ -123,7 +140,7 @@ protected:
     // the amount of priority to reward the preferred operator open lists with
     int pref_priority_reward;
 
-    MTRand_int32 *rand_gen;
+    RandomStream *rand_gen;
     
     // limit on size
     double kb_limit;
@@ -145,7 +162,7 @@ protected:
     void get_preferred_from_closed_list(const State *state_ptr);
     
 public:
-    DelayedWAStar(AxiomEvaluator *a, int s_num, MTRand_int32 *rg, int w,
+    DelayedWAStar(AxiomEvaluator *a, int s_num, RandomStream *rg, int w,
     		string name, bool ignore, bool r=false, double eps = 0.0);
     ~DelayedWAStar();
     
@@ -186,6 +203,8 @@ public:
 
     void set_use_local_bound(){use_local_bound = true;}
     void set_local_bound(int new_bound) {local_bound = new_bound;}
+    // the local bound is lowered to any plan found from now on
+    void set_follow_shared_bound();
 };
 
 #endif
@@ -67,7 +67,6 @@ DomainTransitionGraph::DomainTransitionGraph(int var_index, int node_count) {
     nodes.reserve(node_count);
     for(int value = 0; value < node_count; value++)
         nodes.push_back(ValueNode(this, value));
-    last_helpful_transition_extraction_time = -1;
 }
 
 void DomainTransitionGraph::read_data(istream &in) {
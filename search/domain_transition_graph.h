@@ -39,8 +39,9 @@ class DomainTransitionGraph;
 // Note: We do not use references but pointers to refer to the "parents" of
 // transitions and nodes. This is because these structures could not be
 // put into vectors otherwise.
-
-typedef multimap<int, ValueNode *> Heap;
+//
+// The graphs are shared by all threads, so the CG heuristic keeps the data
+// of its computations to itself.
 
 struct PrevailCondition {
     DomainTransitionGraph *prev_dtg;
@@ -73,18 +74,8 @@ struct ValueNode {
     int value;
     vector<ValueTransition> transitions;
 
-    vector<int> distances;               // cg; empty vector if not yet requested
-    vector<ValueTransitionLabel *> helpful_transitions;
-    // cg; empty vector if not requested
-    Heap::iterator pos_in_heap;          // cg
-    vector<int> children_state;          // cg
-    ValueNode *reached_from;             // cg
-    //ValueNode *helpful_reached_from;     // cg
-    ValueTransitionLabel *reached_by;    // cg
-    //ValueTransitionLabel *helpful_reached_by; // cg
-
     ValueNode(DomainTransitionGraph *parent, int val)
-        : parent_graph(parent), value(val), reached_from(0), reached_by(0) {}
+        : parent_graph(parent), value(val) {}
     void dump() const;
 };
 
@@ -98,8 +89,6 @@ class DomainTransitionGraph {
     bool is_axiom;
     vector<ValueNode> nodes;
 
-    int last_helpful_transition_extraction_time; // cg heuristic; "dirty bit"
-
     vector<int> local_to_global_child;
     // used for mapping variables in conditions to their global index 
     // (only needed for initializing child_state for the start node?)
@@ -33,6 +33,8 @@ FDFFHeuristic::FDFFHeuristic(AxiomEvaluator *a) :
 	reachable_queue_start = 0;
 	reachable_queue_read_pos = 0;
 	reachable_queue_write_pos = 0;
+	relaxed_plan_id = 0;
+	relaxed_plan_size = 0;
 	initialize();
 }
 
@@ -291,23 +293,33 @@ int FDFFHeuristic::compute_ff_heuristic() {
 	if (h_add_heuristic == DEAD_END) {
 		return DEAD_END;
 	} else {
-		RelaxedPlan relaxed_plan;
-		relaxed_plan.resize(2 * h_add_heuristic);
+		// operators and axioms share the index space of get_op_index
+		if (relaxed_plan_mark.empty() || relaxed_plan_id == INT_MAX) {
+			relaxed_plan_mark.assign(g_operators.size() + g_axioms.size(), 0);
+			relaxed_plan_id = 0;
+		}
+		relaxed_plan_id++;
+		relaxed_plan_size = 0;
 		// Collecting the relaxed plan also marks helpful actions as preferred.
 		for (int i = 0; i < goal_propositions.size(); i++)
-			collect_relaxed_plan(goal_propositions[i], relaxed_plan);
-		return relaxed_plan.size();
+			collect_relaxed_plan(goal_propositions[i]);
+		return relaxed_plan_size;
 	}
 }
 
-void FDFFHeuristic::collect_relaxed_plan(FDProposition *goal, RelaxedPlan &relaxed_plan) {
+void FDFFHeuristic::collect_relaxed_plan(FDProposition *goal) {
 	//cout << "collect_relaxed_plan" << endl;
 	FDUnaryOperator *unary_op = goal->reached_by;
 	if (unary_op) { // We have not yet chained back to a start node.
 		for (int i = 0; i < unary_op->precondition.size(); i++)
-			collect_relaxed_plan(unary_op->precondition[i], relaxed_plan);
+			collect_relaxed_plan(unary_op->precondition[i]);
 		const Operator *op = unary_op->op;
-		bool added_to_relaxed_plan = relaxed_plan.insert(op).second;
+		int &mark = relaxed_plan_mark[op->get_op_index()];
+		bool added_to_relaxed_plan = mark != relaxed_plan_id;
+		if (added_to_relaxed_plan) {
+			mark = relaxed_plan_id;
+			relaxed_plan_size++;
+		}
 		if (added_to_relaxed_plan && unary_op->h_add_cost == unary_op->base_cost && !op->is_axiom()) {
 			set_preferred(op); // This is a helpful action.
 		}
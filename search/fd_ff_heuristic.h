@@ -42,7 +42,11 @@ struct FDProposition {
 
 
 class FDFFHeuristic : public Heuristic {
-    typedef __gnu_cxx::hash_set<const Operator *, hash_operator_ptr> RelaxedPlan;
+    // The relaxed plan is the set of operators marked with the number of
+    // the current evaluation, so collecting it does not allocate.
+    std::vector<int> relaxed_plan_mark;
+    int relaxed_plan_id;
+    int relaxed_plan_size;
 
     std::vector<FDUnaryOperator> unary_operators;
     std::vector<std::vector<FDProposition> > propositions;
@@ -60,7 +64,7 @@ class FDFFHeuristic : public Heuristic {
     void setup_exploration_queue();
     void setup_exploration_queue_state(const State &state);
     void relaxed_exploration();
-    void collect_relaxed_plan(FDProposition *goal, RelaxedPlan &relaxed_plan);
+    void collect_relaxed_plan(FDProposition *goal);
 
     int compute_hsp_add_heuristic();
     int compute_ff_heuristic();
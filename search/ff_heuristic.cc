@@ -35,6 +35,7 @@ using namespace __gnu_cxx;
 
 // Construction and destruction
 FFHeuristic::FFHeuristic() : Heuristic() {
+    relaxed_plan_id = 0;
     cout << "Initializing HSP/FF heuristic..." << endl;
 
     // Build propositions.
@@ -67,9 +68,21 @@ FFHeuristic::FFHeuristic() : Heuristic() {
 	for(int j = 0; j < op->precondition.size(); j++)
 	    op->precondition[j]->precondition_of.push_back(op);
     }
-    // Set flag that before heuristic values can be used, computation 
-    // (relaxed exploration) needs to be done
-    heuristic_recomputation_needed = true;
+
+    int max_cost = 0;
+    for(int i = 0; i < unary_operators.size(); i++)
+	max_cost = max(max_cost, unary_operators[i].base_cost);
+    reachable_queue.set_max_cost(max_cost);
+
+    // Before heuristic values can be used, computation (relaxed
+    // exploration) needs to be done
+    context.explored = false;
+    context.has_relaxed_plan = false;
+    context.relaxed_plan_length = DEAD_END;
+    context.relaxed_plan_cost = DEAD_END;
+    plan_measure = PLAN_LENGTH;
+    plan_limit = NO_CUTOFF;
+    plan_aborted = false;
 }
 
 FFHeuristic::~FFHeuristic() {
@@ -95,7 +108,7 @@ void FFHeuristic::set_additional_goals(const std::vector<pair<int, int> >& add_g
 	    termination_propositions.push_back(&propositions[var][val]);
 	}
     }
-    heuristic_recomputation_needed = true;
+    invalidate_context();
 }
 
 void FFHeuristic::build_unary_operators(const Operator &op) {
@@ -210,46 +223,39 @@ void FFHeuristic::setup_exploration_queue(const State &state,
 
 void FFHeuristic::relaxed_exploration(bool use_h_max = false, bool level_out = false) {
     int unsolved_goals = termination_propositions.size();
-    for(int distance = 0; distance < reachable_queue.size(); distance++) {
-        for(;;) {
-            Bucket &bucket = reachable_queue[distance];
-            // NOTE: Cannot set "bucket" outside the loop because the
-            //       reference can change if reachable_queue is
-            //       resized.
-            if(bucket.empty())
-                break;
-            Proposition *prop = bucket.back();
-            bucket.pop_back();
-	    int prop_cost;
-	    if(use_h_max)
-		prop_cost = prop->h_max_cost;
-	    else
-		prop_cost = prop->h_add_cost;
-	    assert(prop_cost <= distance);
-	    if(prop_cost < distance)
+    while(!reachable_queue.empty()) {
+	pair<int, Proposition *> top = reachable_queue.pop();
+	int distance = top.first;
+	Proposition *prop = top.second;
+	int prop_cost;
+	if(use_h_max)
+	    prop_cost = prop->h_max_cost;
+	else
+	    prop_cost = prop->h_add_cost;
+	assert(prop_cost <= distance);
+	if(prop_cost < distance)
+	    continue;
+	if(!level_out && prop->is_termination_condition && --unsolved_goals == 0)
+	    return;
+	const vector<UnaryOperator *> &triggered_operators = prop->precondition_of;
+	for(int i = 0; i < triggered_operators.size(); i++) {
+	    UnaryOperator *unary_op = triggered_operators[i];
+	    if(unary_op->h_add_cost == -2) // operator is not applied
 		continue;
-	    if(!level_out && prop->is_termination_condition && --unsolved_goals == 0)
-                return;
-	    const vector<UnaryOperator *> &triggered_operators = prop->precondition_of;
-	    for(int i = 0; i < triggered_operators.size(); i++) {
-		UnaryOperator *unary_op = triggered_operators[i];
-		if(unary_op->h_add_cost == -2) // operator is not applied
-		    continue;
-		unary_op->unsatisfied_preconditions--;
-		unary_op->h_add_cost += prop_cost;
-		unary_op->h_max_cost = max(prop_cost + unary_op->base_cost, 
-					   unary_op->h_max_cost);
-		unary_op->depth = max(unary_op->depth, prop->depth);
-		assert(unary_op->unsatisfied_preconditions >= 0);
-		if(unary_op->unsatisfied_preconditions == 0) {
-		    int depth = unary_op->op->is_axiom() ? unary_op->depth : unary_op->depth + 1;
-		    if(use_h_max)
-			enqueue_if_necessary(unary_op->effect, unary_op->h_max_cost,
-					     depth, unary_op, use_h_max);
-		    else
-			enqueue_if_necessary(unary_op->effect, unary_op->h_add_cost,
-					     depth, unary_op, use_h_max);
-		}
+	    unary_op->unsatisfied_preconditions--;
+	    unary_op->h_add_cost += prop_cost;
+	    unary_op->h_max_cost = max(prop_cost + unary_op->base_cost, 
+				       unary_op->h_max_cost);
+	    unary_op->depth = max(unary_op->depth, prop->depth);
+	    assert(unary_op->unsatisfied_preconditions >= 0);
+	    if(unary_op->unsatisfied_preconditions == 0) {
+		int depth = unary_op->op->is_axiom() ? unary_op->depth : unary_op->depth + 1;
+		if(use_h_max)
+		    enqueue_if_necessary(unary_op->effect, unary_op->h_max_cost,
+					 depth, unary_op, use_h_max);
+		else
+		    enqueue_if_necessary(unary_op->effect, unary_op->h_add_cost,
+					 depth, unary_op, use_h_max);
 	    }
 	}
     }
@@ -263,17 +269,13 @@ void FFHeuristic::enqueue_if_necessary(Proposition *prop, int cost, int depth,
 	prop->h_max_cost = cost;
 	prop->depth = depth;
 	prop->reached_by = op;
-	if(cost >= reachable_queue.size())
-	    reachable_queue.resize(cost + 1);
-	reachable_queue[cost].push_back(prop);
+	reachable_queue.push(cost, prop);
     }
     else if(!use_h_max && (prop->h_add_cost == -1 || prop->h_add_cost > cost)) {
 	prop->h_add_cost = cost;
 	prop->depth = depth;
 	prop->reached_by = op;
-	if(cost >= reachable_queue.size())
-                reachable_queue.resize(cost + 1);
-	reachable_queue[cost].push_back(prop);
+	reachable_queue.push(cost, prop);
     }
     if(use_h_max)
 	assert(prop->h_max_cost != -1 &&
@@ -311,55 +313,88 @@ int FFHeuristic::get_lower_bound(const State &state) {
 /* Note: this function is currently not used */
     prepare_heuristic_computation(state, true);
     int h = compute_hsp_max_heuristic();
-    heuristic_recomputation_needed = true;
+    invalidate_context();
     return h;
 }
 
 
 void FFHeuristic::compute_ff_heuristic(const State &state) {
+    context.helpful_actions.clear();
     int h_add_heuristic = compute_hsp_add_heuristic();
+    int &relaxed_plan_length = context.relaxed_plan_length;
+    int &relaxed_plan_cost = context.relaxed_plan_cost;
     if(h_add_heuristic == DEAD_END) {
         relaxed_plan_length = DEAD_END;
         relaxed_plan_cost = DEAD_END;
     } else {
-	    RelaxedPlan relaxed_plan;
-	    relaxed_plan.resize(2 * h_add_heuristic);
-	    // Collecting the relaxed plan also marks helpful actions as preferred.
-	    for(int i = 0; i < goal_propositions.size(); i++)
-	        collect_relaxed_plan(goal_propositions[i], relaxed_plan, state);
+	    start_relaxed_plan();
+	    relaxed_plan_length = 0;
+	    // Collecting the relaxed plan also collects the helpful actions.
+	    // The cost is summed up on the way so that the collection can stop
+	    // as soon as the plan exceeds the limit.
+	    relaxed_plan_cost = 0;
+	    plan_aborted = false;
+	    for(int i = 0; i < goal_propositions.size() && !plan_aborted; i++)
+	        collect_relaxed_plan(goal_propositions[i], state);
 	    
-	    relaxed_plan_length = relaxed_plan.size();
-	    if(!g_use_metric) {
+	    if(!g_use_metric)
 	        relaxed_plan_cost = relaxed_plan_length;
-	    }else {
-	 
-	        relaxed_plan_cost = 0;
-	    
-	        RelaxedPlan::iterator it = relaxed_plan.begin();
-	        for(; it != relaxed_plan.end(); ++it)
-		        relaxed_plan_cost += (*it)->get_cost() - 1;
-	    }
     }
 }
 
+void FFHeuristic::start_relaxed_plan() {
+    if(relaxed_plan_mark.empty() || relaxed_plan_id == INT_MAX) {
+        relaxed_plan_mark.assign(g_operators.size(), 0);
+        relaxed_plan_id = 0;
+    }
+    relaxed_plan_id++;
+}
+
+int FFHeuristic::get_plan_measure(int length, int cost) const {
+    if(plan_measure == PLAN_LENGTH)
+        return length;
+    else if(plan_measure == PLAN_COST)
+        return g_use_metric ? cost : length;
+    else
+        return g_use_metric ? length + cost : length;
+}
+
 void FFHeuristic::collect_relaxed_plan(Proposition *goal,
-				       RelaxedPlan &relaxed_plan, const State &state) {
+				       const State &state) {
 
     UnaryOperator *unary_op = goal->reached_by;
     if(unary_op) { // We have not yet chained back to a start node.
-	for(int i = 0; i < unary_op->precondition.size(); i++)
-	    collect_relaxed_plan(unary_op->precondition[i], relaxed_plan, state);
+	for(int i = 0; i < unary_op->precondition.size() && !plan_aborted; i++)
+	    collect_relaxed_plan(unary_op->precondition[i], state);
+	if(plan_aborted)
+	    return;
 	const Operator *op = unary_op->op;
 	bool added_to_relaxed_plan = false;
-	if(!op->is_axiom())
-	    added_to_relaxed_plan = relaxed_plan.insert(op).second;
+	if(!op->is_axiom()) {
+	    int &mark = relaxed_plan_mark[op->get_op_index()];
+	    added_to_relaxed_plan = mark != relaxed_plan_id;
+	    mark = relaxed_plan_id;
+	}
+
+	if(added_to_relaxed_plan) {
+	    context.relaxed_plan_length++;
+	    if(g_use_metric)
+		context.relaxed_plan_cost += op->get_cost() - 1;
+	    // both measures only grow, so the plan can be given up right away
+	    if(get_plan_measure(context.relaxed_plan_length,
+	                        context.relaxed_plan_cost)
+	       > plan_limit) {
+		plan_aborted = true;
+		return;
+	    }
+	}
 
 	assert(unary_op->depth != -1);
 	if(added_to_relaxed_plan
 	   && unary_op->h_add_cost == unary_op->base_cost
 	   && unary_op->depth == 0
 	   && !op->is_axiom()) {
-            set_preferred(op);
+            context.helpful_actions.push_back(op);
             assert(op->is_applicable(state));
 	}
     }
@@ -423,45 +458,85 @@ compute_reachability_with_excludes(vector<vector<int> >& lvl_var,
 		lvl_op[op_index].find(effect)->second = new_lvl;
 	}
     }
-    heuristic_recomputation_needed = true;
+    invalidate_context();
 }
 
 void FFHeuristic::prepare_heuristic_computation(const State& state, bool h_max = false) {
     setup_exploration_queue(state, h_max);
     relaxed_exploration(h_max);
-    heuristic_recomputation_needed = false;
 }
 
-int FFHeuristic::compute_heuristic(const State &state) {
-    if(heuristic_recomputation_needed) {
-	prepare_heuristic_computation(state);
+void FFHeuristic::explore(const State &state) {
+    if(context.explored) {
+	bool same_state = true;
+	for(int var = 0; var < context.state.size() && same_state; var++)
+	    same_state = (context.state[var] == state[var]);
+	if(same_state)
+	    return;
     }
+    prepare_heuristic_computation(state);
+    context.state.resize(propositions.size());
+    for(int var = 0; var < propositions.size(); var++)
+	context.state[var] = state[var];
+    context.explored = true;
+    context.has_relaxed_plan = false;
+}
+
+bool FFHeuristic::compute_relaxed_plan(const State &state,
+				       PlanMeasure measure, int limit) {
+    explore(state);
+    if(context.has_relaxed_plan)
+	return true;
+
+    plan_measure = measure;
+    plan_limit = limit;
     compute_ff_heuristic(state);
+    if(plan_aborted) {
+	// the exploration stays valid, only the plan has to be collected
+	// again if it is asked for with a larger limit
+	plan_aborted = false;
+	return false;
+    }
+    context.has_relaxed_plan = true;
+    return true;
+}
+
+int FFHeuristic::compute_heuristic(const State &state) {
+    PlanMeasure measure = g_use_metric ? PLAN_LENGTH_AND_COST : PLAN_LENGTH;
+    if(!compute_relaxed_plan(state, measure, get_cutoff()))
+        return PRUNED;
     
-    if(relaxed_plan_length == DEAD_END)
+    if(context.relaxed_plan_length == DEAD_END)
         return DEAD_END;
-    
+
+    for(int i = 0; i < context.helpful_actions.size(); i++)
+	set_preferred(context.helpful_actions[i]);
     if(g_use_metric)
-        return relaxed_plan_length + relaxed_plan_cost;
+        return context.relaxed_plan_length + context.relaxed_plan_cost;
     else
-        return relaxed_plan_length;
+        return context.relaxed_plan_length;
 }
 
 
-void FFHeuristic::collect_ha(Proposition *goal,
-                             RelaxedPlan &relaxed_plan, const State &state) {
+int FFHeuristic::collect_ha(Proposition *goal, const State &state) {
 
     // This is the same as collect_relaxed_plan, except that preferred operators
     // are saved in exported_ops rather than preferred_operators
 
+    int num_added = 0;
     UnaryOperator *unary_op = goal->reached_by;
     if(unary_op) { // We have not yet chained back to a start node.
 	for(int i = 0; i < unary_op->precondition.size(); i++)
-	    collect_ha(unary_op->precondition[i], relaxed_plan, state);
+	    num_added += collect_ha(unary_op->precondition[i], state);
 	const Operator *op = unary_op->op;
 	bool added_to_relaxed_plan = false;
-	if(!op->is_axiom())
-	    added_to_relaxed_plan = relaxed_plan.insert(op).second;
+	if(!op->is_axiom()) {
+	    int &mark = relaxed_plan_mark[op->get_op_index()];
+	    added_to_relaxed_plan = mark != relaxed_plan_id;
+	    mark = relaxed_plan_id;
+	}
+	if(added_to_relaxed_plan)
+	    num_added++;
 	if(added_to_relaxed_plan
 	   && unary_op->h_add_cost == unary_op->base_cost
 	   && unary_op->depth == 0
@@ -470,6 +545,7 @@ void FFHeuristic::collect_ha(Proposition *goal,
             assert(op->is_applicable(state));
 	}
     }
+    return num_added;
 }
 
 bool is_landmark(vector<pair<int, int> >& landmarks, int var, int val) {
@@ -482,13 +558,12 @@ bool is_landmark(vector<pair<int, int> >& landmarks, int var, int val) {
 
 int FFHeuristic::plan_for_disj(vector<pair<int, int> >& landmarks, 
 			       const State& state) {
-    RelaxedPlan relaxed_plan;
+    start_relaxed_plan();
+    int relaxed_plan_length = 0;
     // generate plan to reach part of disj. goal OR if no landmarks given, plan to real goal
     if(!landmarks.empty()) {
         // search for quickest achievable landmark leaves
-	if(heuristic_recomputation_needed) {
-	    prepare_heuristic_computation(state);
-	}
+	explore(state);
 	int min_cost = INT_MAX;
 	Proposition *target = NULL;
 	for(int i = 0; i < termination_propositions.size(); i++) {
@@ -504,24 +579,17 @@ int FFHeuristic::plan_for_disj(vector<pair<int, int> >& landmarks,
 	    }
 	}
 	assert(target != NULL);
-	relaxed_plan.resize(2 * min_cost);
 	assert(exported_ops.size() == 0);
-	collect_ha(target, relaxed_plan, state);
+	relaxed_plan_length += collect_ha(target, state);
     } else {
         // search for original goals of the task
-	if(heuristic_recomputation_needed) {
-	    prepare_heuristic_computation(state);
-	}   
+	explore(state);
 	for(int i = 0; i < goal_propositions.size(); i++) {
 	    if(goal_propositions[i]->h_add_cost == -1)
 		return DEAD_END;
-	    collect_ha(goal_propositions[i], relaxed_plan, state);
+	    relaxed_plan_length += collect_ha(goal_propositions[i], state);
 	}
     }
-    return relaxed_plan.size();
-}
-
-void FFHeuristic::set_recompute_heuristic(const State &) {
-    heuristic_recomputation_needed = true;
+    return relaxed_plan_length;
 }
 
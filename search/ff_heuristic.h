@@ -28,6 +28,7 @@
 #include "heuristic.h"
 #include "globals.h"
 #include "landmarks_types.h"
+#include "priority_queues.h"
 
 #include <vector>
 #include <ext/hash_set>
@@ -106,18 +107,48 @@ class LandmarksCountHeuristic;
 
 class FFHeuristic : public Heuristic {
     friend class LandmarksCountHeuristic;
-
-    typedef __gnu_cxx::hash_set<const Operator *, hash_operator_ptr> RelaxedPlan;
+public:
+    // what the limit of compute_relaxed_plan applies to: the number of
+    // actions, their cost or the sum of both, which is the FF value with
+    // action costs
+    enum PlanMeasure {PLAN_LENGTH, PLAN_COST, PLAN_LENGTH_AND_COST};
+private:
 
     std::vector<UnaryOperator> unary_operators;
     std::vector<std::vector<Proposition> > propositions;
     std::vector<Proposition *> goal_propositions;
     std::vector<Proposition *> termination_propositions;
 
-    typedef std::vector<Proposition *> Bucket;
-    std::vector<Bucket> reachable_queue;
-
-    bool heuristic_recomputation_needed;
+    MonotoneQueue<Proposition *> reachable_queue;
+
+    // Everything derived from the relaxed exploration of one state. FF,
+    // LAMA_FF_S, LAMA_FF_C, FF_SWITCH and the landmark count heuristic all
+    // read it, so the exploration and the relaxed plan are computed once per
+    // state whatever order these heuristics are evaluated in.
+    struct EvaluationContext {
+        std::vector<int> state; // state that was explored
+        bool explored;          // exploration is valid for state
+        bool has_relaxed_plan;
+        int relaxed_plan_length;
+        int relaxed_plan_cost;
+        std::vector<const Operator *> helpful_actions;
+    };
+    EvaluationContext context;
+
+    // bound on the relaxed plan while it is collected
+    PlanMeasure plan_measure;
+    int plan_limit;
+    bool plan_aborted;
+    int get_plan_measure(int length, int cost) const;
+
+    // The relaxed plan is the set of operators marked with the number of
+    // the current plan, so collecting it does not allocate.
+    std::vector<int> relaxed_plan_mark;
+    int relaxed_plan_id;
+    void start_relaxed_plan();
+
+    void explore(const State &state);
+    void invalidate_context() {context.explored = false;}
 
     void build_unary_operators(const Operator &op);
 
@@ -126,33 +157,31 @@ class FFHeuristic : public Heuristic {
 				 const __gnu_cxx::hash_set<const Operator *, 
 				 hash_operator_ptr>& excluded_ops,
 				 bool use_h_max);
+    // nothing excluded, kept so that an empty hash set is not built for
+    // every state
+    std::vector<std::pair<int, int> > no_excluded_props;
+    __gnu_cxx::hash_set<const Operator *, hash_operator_ptr> no_excluded_ops;
     inline void setup_exploration_queue(const State &state, bool h_max) {
-	std::vector<std::pair<int, int> > excluded_props;
-	__gnu_cxx::hash_set<const Operator *, hash_operator_ptr> excluded_ops;
-	setup_exploration_queue(state, excluded_props, excluded_ops, h_max);
+	setup_exploration_queue(state, no_excluded_props, no_excluded_ops, h_max);
     }
     void relaxed_exploration(bool use_h_max, bool level_out);
     void prepare_heuristic_computation(const State& state, bool h_max);
-    void collect_relaxed_plan(Proposition *goal, RelaxedPlan &relaxed_plan, const State &state);
+    void collect_relaxed_plan(Proposition *goal, const State &state);
 
     int compute_hsp_add_heuristic();
     int compute_hsp_max_heuristic();
     void compute_ff_heuristic(const State &state);
 
-    void collect_ha(Proposition *goal, RelaxedPlan &relaxed_plan, const State &state);
+    // adds the operators to the relaxed plan, returns how many were new
+    int collect_ha(Proposition *goal, const State &state);
 
     void enqueue_if_necessary(Proposition *prop, int cost, int depth, UnaryOperator *op, 
 			      bool use_h_max);
-protected:
-    
-    int relaxed_plan_length;
-    int relaxed_plan_cost;
 public:
     
     int compute_heuristic(const State &state);
     int get_lower_bound(const State &state);
     void set_additional_goals(const std::vector<std::pair<int, int> >& goals);
-    virtual void set_recompute_heuristic(const State &state);
     void compute_reachability_with_excludes(std::vector<std::vector<int> >& lvl_var, 
 					    std::vector<__gnu_cxx::hash_map<pair<int, int>, int, 
 					    hash_int_pair> >& lvl_op,
@@ -167,8 +196,18 @@ public:
     ~FFHeuristic();
     virtual string get_heuristic_name(){return "LAMA_FF";}
     
-    int get_relaxed_plan_length(){return relaxed_plan_length;}
-    int get_relaxed_plan_cost(){return relaxed_plan_cost;}
+    // Computes the relaxed plan of state unless it is already known. The
+    // getters below then refer to this plan. Collecting the plan is given up
+    // as soon as its measure exceeds limit, in which case false is returned
+    // and the getters must not be used.
+    bool compute_relaxed_plan(const State &state,
+                              PlanMeasure measure = PLAN_LENGTH,
+                              int limit = NO_CUTOFF);
+    int get_relaxed_plan_length() const {return context.relaxed_plan_length;}
+    int get_relaxed_plan_cost() const {return context.relaxed_plan_cost;}
+    const std::vector<const Operator *> &get_helpful_actions() const {
+        return context.helpful_actions;
+    }
 
 };
 
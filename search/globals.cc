@@ -38,6 +38,8 @@ using namespace std;
 #include "domain_transition_graph.h"
 #include "operator.h"
 #include "state.h"
+#include "state_hash.h"
+#include "heuristic_cache.h"
 #include "successor_generator.h"
 #include "landmarks_graph.h"
 #include "landmarks_graph_rpg_sasp.h"
@@ -99,14 +101,16 @@ int save_plan(const vector<const Operator *> &plan, const string& filename,
 	    cout << thread_name << "Plan Validated" << endl;
 	
 	int plan_cost = compute_cost(plan);
-	if(g_best_sol_cost != -1 && plan_cost >= g_best_sol_cost) {
+	if(!g_solution_bound.improve(plan_cost)) {
 		cout << thread_name  << "Last complete plan has cost " << plan_cost <<
 				" and is not being printed" << endl;
 
 		pthread_mutex_unlock(&mutex_save_plan); // release lock
 		return plan_cost;
 	}
-	g_best_sol_cost = plan_cost;
+	// the other threads need not wait for the plan to be written
+	if(!g_iterative)
+		g_solution_bound.cancel();
 
 	bool separate_outfiles = g_iterative; // IPC conditions, change to false for a single outfile.
 	if (separate_outfiles) {
@@ -214,6 +218,21 @@ void read_operators(istream &in) {
         g_operators.push_back(Operator(in, false));
 }
 
+void read_causal_graph(istream &in) {
+    check_magic(in, "begin_CG");
+    g_causal_graph.resize(g_variable_domain.size());
+    for(int var = 0; var < g_variable_domain.size(); var++) {
+        int count;
+        in >> count;
+        for(int i = 0; i < count; i++) {
+            int succ, weight;
+            in >> succ >> weight;
+            g_causal_graph[var].push_back(make_pair(succ, weight));
+        }
+    }
+    check_magic(in, "end_CG");
+}
+
 void read_axioms(istream &in) {
     int count;
     in >> count;
@@ -228,20 +247,53 @@ void read_axioms(istream &in) {
 
 void build_landmarks_graph(bool reasonable_orders) {
     g_lgraph = new LandmarksGraphNew();
-    g_lgraph->read_external_inconsistencies();
-    if(reasonable_orders) {
-	g_lgraph->use_reasonable_orders();
+    if(!g_lm_cache_file.empty() &&
+       g_lgraph->load(g_lm_cache_file, g_task_fingerprint)) {
+	cout << "Loaded landmarks graph from " << g_lm_cache_file << endl;
+    } else {
+	g_lgraph->read_external_inconsistencies();
+	if(reasonable_orders) {
+	    g_lgraph->use_reasonable_orders();
+	}
+	g_lgraph->generate();
+	if(!g_lm_cache_file.empty())
+	    g_lgraph->save(g_lm_cache_file, g_task_fingerprint);
     }
-    g_lgraph->generate();
     cout << "Generated " << g_lgraph->number_of_landmarks() << " landmarks, of which "
 	 << g_lgraph->number_of_disj_landmarks() << " are disjunctive" << endl
 	 << "          " << g_lgraph->number_of_edges() << " edges\n";
     //g_lgraph->dump();
 }
 
+// FNV-1a and a second, multiplicative hash over the bytes of text
+static void hash_text(const string &text, unsigned int &h1, unsigned int &h2) {
+    for(int i = 0; i < text.size(); i++) {
+	unsigned char byte = text[i];
+	h1 = (h1 ^ byte) * 16777619U;
+	h2 = h2 * 31 + byte;
+    }
+}
+
+void compute_task_fingerprint(const string &task, bool reasonable_orders) {
+    ifstream groups_file(g_all_groups_file.c_str());
+    stringstream groups;
+    groups << groups_file.rdbuf();
+
+    unsigned int h1 = 2166136261U, h2 = 0;
+    hash_text(task, h1, h2);
+    hash_text(groups.str(), h1, h2);
+    g_task_fingerprint.clear();
+    g_task_fingerprint.push_back(task.size());
+    g_task_fingerprint.push_back(groups.str().size());
+    g_task_fingerprint.push_back(h1);
+    g_task_fingerprint.push_back(mix_hash_bits(h2));
+    g_task_fingerprint.push_back(reasonable_orders);
+}
+
 void read_everything(istream &in, bool generate_landmarks, bool reasonable_orders) {
     read_metric(in);
     read_variables(in);
+    init_state_hash_keys();
     g_initial_state = new State(in);
     g_initial_aras_state = new ArasState(*g_initial_state);
     //g_initial_state->dump();
@@ -253,6 +305,7 @@ void read_everything(istream &in, bool generate_landmarks, bool reasonable_order
     g_successor_generator = read_successor_generator(in);
     check_magic(in, "end_SG");
     DomainTransitionGraph::read_all(in);
+    read_causal_graph(in);
     if(generate_landmarks){
 	    build_landmarks_graph(reasonable_orders);
     }
@@ -312,17 +365,6 @@ void print_peak_memory() {
     cout << "Peak memory: " << get_peak_memory_in_kb() << " KB" << endl;
 }
 
-int get_current_seed(int seed_increment) {
-
-	int next_seed = g_seed_list[g_seed_index];
-
-	if(g_seed_index == g_seed_list.size() - 1)
-		g_seed_list[g_seed_list.size() - 1] += seed_increment;
-	else
-		g_seed_index++;
-	return next_seed;
-}
-
 bool g_use_metric;
 vector<string> g_variable_name;
 vector<int> g_variable_domain;
@@ -335,10 +377,13 @@ vector<Operator> g_axioms;
 AxiomEvaluator *g_axiom_evaluator;
 SuccessorGenerator *g_successor_generator;
 vector<DomainTransitionGraph *> g_transition_graphs;
+vector<vector<pair<int, int> > > g_causal_graph;
 
 LandmarksGraph *g_lgraph;
 
 string g_all_groups_file;
+string g_lm_cache_file;
+vector<unsigned int> g_task_fingerprint;
 string g_output_filename;
 int g_sol_number = 1;
 
@@ -351,19 +396,29 @@ int g_min_action_cost;
 PredecessorGenerator *g_predecessor_generator;
 Shared_MRW_Parameters *g_mrw_shared = NULL;
 
-UCB* p_learner = NULL;
-int g_best_sol_cost = -1;
+UCBStats* g_ucb_stats = NULL;
+MRWScheduler* g_mrw_scheduler = NULL;
+SolutionBound g_solution_bound;
 ClosedList<State, const Operator *> g_closed_list;
 
 WalkPool* g_walk_pool = NULL;
+SharedActionValues* g_action_values = NULL;
 vector<const Operator *> g_init_trajectory;
 
 const char * g_init_trajectory_file = NULL;
 
-pthread_mutex_t mutex_p_learner;
-pthread_mutex_t mutex_w_pool;
-
-vector<int> g_seed_list;
-int g_seed_index = 0;
+unsigned int g_seed;
 
 bool g_iterative = false;
+
+HeuristicCache *g_heuristic_cache = NULL;
+int g_h_cache_kb = -1;
+int g_h_cache_policy = HeuristicCache::REPLACE_HIGH_H;
+
+DeadEndStore *g_dead_end_store = NULL;
+int g_dead_end_store_kb = -1;
+
+PDBCollection *g_pdb_collection = NULL;
+int g_pdb_kb = -1;
+
+ThreadPool *g_thread_pool = NULL;
@@ -33,6 +33,7 @@
 #include "shared_mrw_parameters.h"
 #include "parameter_learner.h"
 #include "closed_list.h"
+#include "solution_bound.h"
 
 #include <limits.h>
 
@@ -63,12 +64,22 @@ class MRW_Parameters;
 class ArasState;
 class PredecessorGenerator;
 class WalkPool;
+class HeuristicCache;
+class DeadEndStore;
+class ThreadPool;
+class PDBCollection;
+class MRWScheduler;
+class SharedActionValues;
 
 // reads everything from file
 void read_everything(istream &in, bool generate_landmarks,
 		bool reasonable_orders);
 void dump_everything();
 
+// fingerprints the task text that is read by read_everything, together with
+// the groups file and the landmark options, for g_task_fingerprint
+void compute_task_fingerprint(const string &task, bool reasonable_orders);
+
 // checks if the given state is a goal
 bool check_goal(State* state);
 
@@ -91,9 +102,6 @@ int get_peak_memory_in_kb();
 // prints the peak amount of memory to stdout
 void print_peak_memory();
 
-// get current seed. Only increments if we have run out of seeds
-int get_current_seed(int seed_increment);
-
 struct hash_operator_ptr {
     size_t operator()(const Operator *key) const {
 	return reinterpret_cast<unsigned long>(key);
@@ -137,6 +145,11 @@ extern SuccessorGenerator *g_successor_generator;
 // beginning, should be fine
 extern vector<DomainTransitionGraph *> g_transition_graphs;
 
+// causal graph of the task: for every variable, the variables that it
+// influences together with the number of operators and axioms inducing the
+// arc. Only built at the beginning.
+extern vector<vector<pair<int, int> > > g_causal_graph;
+
 // shared landmarks graph - all public functions are const-methods, so no worries
 // used primarily by LM heuristic, which seems to copy it anyways, so probably
 // not a big deal
@@ -145,6 +158,11 @@ extern LandmarksGraph *g_lgraph;
 // only used once to build everything up
 extern string g_all_groups_file;
 
+// file the landmarks graph is loaded from if it was written for a task with
+// the same fingerprint, and saved to otherwise. Empty if not used.
+extern string g_lm_cache_file;
+extern vector<unsigned int> g_task_fingerprint;
+
 // main file name to output to, g_sol_number is added to the back
 extern string g_output_filename;
 extern int g_sol_number;
@@ -163,28 +181,51 @@ extern PredecessorGenerator *g_predecessor_generator;
 // shared mrw parameters
 extern Shared_MRW_Parameters *g_mrw_shared;
 
-// parameter learner for mrw
-extern UCB* p_learner;
-extern pthread_mutex_t mutex_p_learner;
+// statistics of the parameter learners of the mrw threads
+extern UCBStats* g_ucb_stats;
+// runs the steps of the mrw engines
+extern MRWScheduler* g_mrw_scheduler;
 
-// This is the actual cost (not the adjusted cost) of the best solution found
-// so far. Initialized as 0
-extern int g_best_sol_cost;
+// actual cost (not the adjusted cost) of the best solution found so far
+extern SolutionBound g_solution_bound;
 
 // best first search closed list.
 extern ClosedList<State, const Operator *> g_closed_list;
 
 // pool for mrw walks
 extern WalkPool* g_walk_pool;
-extern pthread_mutex_t mutex_w_pool;
+
+// action values of the walks of all mrw threads, NULL if every walker
+// learns its own
+extern SharedActionValues* g_action_values;
 
 // name of init trajectory file and actual trajectory
 extern const char * g_init_trajectory_file;
 extern vector<const Operator *> g_init_trajectory;
 
-extern vector<int> g_seed_list;
-extern int g_seed_index;
+// the master seed, which all RandomStreams are derived from
+extern unsigned int g_seed;
 
 extern bool g_iterative;
 
+// heuristic transposition table shared by all threads, NULL if not used.
+// Size in KB (-1 if no cache is used) and replacement policy.
+extern HeuristicCache *g_heuristic_cache;
+extern int g_h_cache_kb;
+extern int g_h_cache_policy;
+
+// store of learned dead ends shared by all threads, NULL if not used. Size in
+// KB (-1 if no store is used).
+extern DeadEndStore *g_dead_end_store;
+extern int g_dead_end_store_kb;
+
+// pattern databases shared by all PDB heuristics, NULL if not used. Size in
+// KB (-1 for the default size).
+extern PDBCollection *g_pdb_collection;
+extern int g_pdb_kb;
+
+// threads for parallel work before the searches start, like building the
+// landmark graph. Has as many threads as there are search threads.
+extern ThreadPool *g_thread_pool;
+
 #endif
@@ -22,17 +22,28 @@
  *********************************************************************/
 
 #include "heuristic.h"
+#include "globals.h"
+#include "heuristic_cache.h"
 #include "state.h"
+#include "successor_generator.h"
 
 #ifndef NDEBUG
 #include "operator.h"
 #endif
 
 #include <cassert>
+#include <iostream>
 using namespace std;
 
 Heuristic::Heuristic() {
     heuristic = INVALID;
+    cache = 0;
+    cache_id = 0;
+    cache_needs_preferred = true;
+    cache_hits = 0;
+    cache_misses = 0;
+    applicable_ops = 0;
+    cutoff = NO_CUTOFF;
 }
 
 Heuristic::~Heuristic() {
@@ -42,11 +53,42 @@ void Heuristic::set_preferred(const Operator *op) {
     preferred_operators.push_back(op);
 }
 
-void Heuristic::evaluate(const State &state) {
+const vector<const Operator *> &Heuristic::get_applicable_ops(
+        const State &state) {
+    if(applicable_ops == 0) {
+        generated_applicable_ops.clear();
+        g_successor_generator->generate_applicable_ops(state,
+                generated_applicable_ops);
+        applicable_ops = &generated_applicable_ops;
+    }
+    return *applicable_ops;
+}
+
+void Heuristic::evaluate(const State &state,
+        const vector<const Operator *> *applicable, int c) {
 
     preferred_operators.clear();
+    applicable_ops = applicable;
+    cutoff = c;
+
+    StateHash key;
+    if(cache != 0) {
+        key = get_cache_key(state);
+        key.mix(cache_id);
+        if(cache->lookup(key, cache_needs_preferred, heuristic,
+                preferred_operators)) {
+            cache_hits++;
+            apply_cutoff(c);
+            return;
+        }
+        cache_misses++;
+    }
+
     heuristic = compute_heuristic(state);
-    assert(heuristic == DEAD_END || heuristic >= 0);
+    applicable_ops = 0;
+    cutoff = NO_CUTOFF;
+    assert(heuristic == DEAD_END || heuristic >= 0 ||
+           (heuristic == PRUNED && c != NO_CUTOFF));
 
     if(heuristic == DEAD_END) {
 	// It is ok to have preferred operators in dead-end states.
@@ -57,11 +99,23 @@ void Heuristic::evaluate(const State &state) {
     }
 
 #ifndef NDEBUG
-    if(heuristic != DEAD_END) {
+    if(heuristic >= 0) {
 	for(int i = 0; i < preferred_operators.size(); i++)
 	    assert(preferred_operators[i]->is_applicable(state));
     }
 #endif
+
+    // a pruned evaluation is incomplete and must not be cached
+    if(cache != 0 && heuristic != PRUNED)
+        cache->store(key, heuristic, preferred_operators);
+    apply_cutoff(c);
+}
+
+void Heuristic::apply_cutoff(int c) {
+    if(heuristic != DEAD_END && heuristic > c)
+        heuristic = PRUNED;
+    if(heuristic == PRUNED)
+        preferred_operators.clear();
 }
 
 bool Heuristic::is_dead_end() {
@@ -86,3 +140,26 @@ void Heuristic::get_preferred_operators(std::vector<const Operator *> &result) {
 }
 
 void Heuristic::set_recompute_heuristic(const State &){}
+
+StateHash Heuristic::get_cache_key(const State &state) {
+    return state.get_hash();
+}
+
+void Heuristic::set_cache(HeuristicCache *c) {
+    cache = c;
+    cache_id = HeuristicCache::get_heuristic_id(get_heuristic_name());
+}
+
+void Heuristic::print_cache_statistics(const string &prefix,
+                                       int other_hits, int other_misses) {
+    if(cache == 0)
+        return;
+    int hits = cache_hits + other_hits;
+    int misses = cache_misses + other_misses;
+    int lookups = hits + misses;
+    cout << prefix << "Heuristic cache (" << get_heuristic_name() << "): "
+         << hits << " hits, " << misses << " misses";
+    if(lookups > 0)
+        cout << " (" << (100.0 * hits) / lookups << "% hit rate)";
+    cout << endl;
+}
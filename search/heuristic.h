@@ -24,38 +24,96 @@
 #ifndef HEURISTIC_H
 #define HEURISTIC_H
 
+#include <climits>
 #include <map>
 #include <vector>
 #include <string>
 
+#include "state_hash.h"
+
 class Operator;
 class State;
+class HeuristicCache;
 
 
 class Heuristic {
 
     enum {INVALID = -2};
 
+    // shared transposition table, NULL if not used
+    HeuristicCache *cache;
+    unsigned int cache_id;
+    bool cache_needs_preferred;
+    int cache_hits;
+    int cache_misses;
+
+    // applicable operators of the state being evaluated if already known
+    const std::vector<const Operator *> *applicable_ops;
+    std::vector<const Operator *> generated_applicable_ops;
+
+    // values above the cutoff of the current evaluation are not needed
+    int cutoff;
+    void apply_cutoff(int c);
+
 protected:
     std::vector<const Operator *> preferred_operators;
 
 	int heuristic;
     virtual int compute_heuristic(const State &state) = 0;
     void set_preferred(const Operator *op);
+
+    // Applicable operators of the state being evaluated. They are only
+    // generated if they were not passed to evaluate.
+    const std::vector<const Operator *> &get_applicable_ops(const State &state);
+
+    // compute_heuristic may stop as soon as it knows that the value is
+    // larger than this and return PRUNED
+    int get_cutoff() const {return cutoff;}
+
+    // Fingerprint under which the value of the state is cached. Heuristics
+    // whose value depends on more than the state variables must mix that
+    // information in.
+    virtual StateHash get_cache_key(const State &state);
 public:
-	enum {DEAD_END = -1};
+	enum {DEAD_END = -1, PRUNED = -3};
+	enum {NO_CUTOFF = INT_MAX};
     Heuristic();
     virtual ~Heuristic();
 
-    void evaluate(const State &state);
+    // If the caller has already generated the applicable operators of the
+    // state, passing them saves heuristics from generating them again.
+    // If the caller discards states whose value is larger than cutoff, the
+    // evaluation may stop early for them; is_pruned() is then true and
+    // neither the value nor preferred operators are available.
+    void evaluate(const State &state,
+            const std::vector<const Operator *> *applicable = 0,
+            int cutoff = NO_CUTOFF);
     bool is_dead_end();
+    bool is_pruned() {return heuristic == PRUNED;}
     int get_heuristic();
     void get_preferred_operators(std::vector<const Operator *> &result);
     virtual void set_recompute_heuristic(const State &state);
     virtual bool dead_ends_are_reliable() {return true;}
+    // false for heuristics that are cheaper to compute than to look up
+    virtual bool is_worth_caching() {return true;}
+    // true if the value depends on the landmarks reached on the way to the
+    // state, which random walks only keep track of if needed
+    virtual bool uses_reached_landmarks() {return false;}
     virtual std::string get_heuristic_name() = 0;
     
     void clear_preferred_ops(){preferred_operators.clear();}
+
+    // Looks up and stores values in the given shared cache from now on
+    void set_cache(HeuristicCache *c);
+    // If preferred operators are not needed, cache entries whose preferred
+    // operators were truncated are still used
+    void set_cache_needs_preferred(bool needed) {cache_needs_preferred = needed;}
+    int get_cache_hits() const {return cache_hits;}
+    int get_cache_misses() const {return cache_misses;}
+    // The given hits and misses, as of copies of the heuristic that other
+    // threads use, are counted in as well.
+    void print_cache_statistics(const std::string &prefix,
+                                int other_hits = 0, int other_misses = 0);
 };
 
 #endif
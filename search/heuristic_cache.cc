@@ -0,0 +1,187 @@
+#include "heuristic_cache.h"
+
+#include "globals.h"
+#include "operator.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <climits>
+
+// bits of the info word of an entry
+#define CACHE_ENTRY_VALID 1U
+#define CACHE_PREFS_TRUNCATED 2U
+#define CACHE_NUM_PREFS_SHIFT 8
+
+using namespace std;
+
+HeuristicCache::HeuristicCache(int size_kb, int replacement_policy) :
+        policy(replacement_policy) {
+
+    // number of buckets is the largest power of two that fits the limit
+    unsigned int max_buckets = ((unsigned int) size_kb * 1024) /
+            (2 * sizeof(Entry));
+    unsigned int num_buckets = 1;
+    while(2 * num_buckets <= max_buckets)
+        num_buckets *= 2;
+    bucket_mask = num_buckets - 1;
+
+    // buckets are aligned to cache lines
+    void *memory = 0;
+    if(posix_memalign(&memory, 64, 2 * num_buckets * sizeof(Entry)) != 0) {
+        cerr << "Unable to allocate heuristic cache of " << size_kb << " KB"
+                << endl;
+        exit(1);
+    }
+    entries = (Entry *) memory;
+    for(unsigned int i = 0; i < 2 * num_buckets; i++) {
+        entries[i].check = 0;
+        entries[i].info = 0;
+        entries[i].value = 0;
+        for(int j = 0; j < MAX_PREFS; j++)
+            entries[i].prefs[j] = 0;
+    }
+}
+
+HeuristicCache::~HeuristicCache() {
+    free(entries);
+}
+
+unsigned int HeuristicCache::compute_check(const Entry &entry) {
+    unsigned int check = mix_hash_bits(entry.info) ^ (unsigned int) entry.value;
+    for(int i = 0; i < MAX_PREFS; i++)
+        check = mix_hash_bits(check ^ (unsigned int) entry.prefs[i]);
+    return check;
+}
+
+bool HeuristicCache::lookup(const StateHash &key, bool need_prefs,
+        int &value, vector<const Operator *> &prefs) const {
+
+    const Entry *bucket = &entries[2 * (key.index & bucket_mask)];
+    for(int slot = 0; slot < 2; slot++) {
+
+        // take a snapshot so that the entry is verified and used as one
+        Entry entry;
+        entry.check = bucket[slot].check;
+        entry.info = bucket[slot].info;
+        entry.value = bucket[slot].value;
+        for(int i = 0; i < MAX_PREFS; i++)
+            entry.prefs[i] = bucket[slot].prefs[i];
+
+        if(!(entry.info & CACHE_ENTRY_VALID) ||
+                entry.check != (key.check ^ compute_check(entry)))
+            continue;
+
+        if(need_prefs && (entry.info & CACHE_PREFS_TRUNCATED))
+            return false;
+
+        int num_prefs = entry.info >> CACHE_NUM_PREFS_SHIFT;
+        if(num_prefs > MAX_PREFS)
+            return false;
+
+        value = entry.value;
+        for(int i = 0; i < num_prefs; i++) {
+            if(entry.prefs[i] < 0 || entry.prefs[i] >= g_operators.size())
+                return false;
+            prefs.push_back(&g_operators[entry.prefs[i]]);
+        }
+        return true;
+    }
+    return false;
+}
+
+void HeuristicCache::write_entry(Entry &entry, unsigned int check, int value,
+        const vector<const Operator *> &prefs) {
+
+    Entry data;
+    int num_prefs = prefs.size();
+    data.info = CACHE_ENTRY_VALID;
+    if(num_prefs > MAX_PREFS) {
+        data.info |= CACHE_PREFS_TRUNCATED;
+        num_prefs = MAX_PREFS;
+    }
+    data.info |= num_prefs << CACHE_NUM_PREFS_SHIFT;
+    data.value = value;
+    for(int i = 0; i < MAX_PREFS; i++) {
+        if(i < num_prefs)
+            data.prefs[i] = prefs[i]->get_op_index();
+        else
+            data.prefs[i] = 0;
+    }
+
+    // the check word is written last, a reader that sees a partially
+    // written entry fails to verify it
+    entry.info = data.info;
+    entry.value = data.value;
+    for(int i = 0; i < MAX_PREFS; i++)
+        entry.prefs[i] = data.prefs[i];
+    entry.check = check ^ compute_check(data);
+}
+
+void HeuristicCache::store(const StateHash &key, int value,
+        const vector<const Operator *> &prefs) {
+
+    Entry *bucket = &entries[2 * (key.index & bucket_mask)];
+
+    int slot = -1;
+    for(int i = 0; i < 2 && slot == -1; i++) {
+        if(!(bucket[i].info & CACHE_ENTRY_VALID))
+            continue;
+        Entry entry;
+        entry.info = bucket[i].info;
+        entry.value = bucket[i].value;
+        for(int j = 0; j < MAX_PREFS; j++)
+            entry.prefs[j] = bucket[i].prefs[j];
+        if(bucket[i].check == (key.check ^ compute_check(entry)))
+            slot = i;
+    }
+
+    if(slot == -1 && policy == REPLACE_ALWAYS) {
+        slot = key.check >> 31;
+    } else if(slot == -1) {
+        assert(policy == REPLACE_HIGH_H);
+
+        // use an empty slot or evict the entry with the higher value. States
+        // close to the goal are the ones most likely to be visited again.
+        if(!(bucket[0].info & CACHE_ENTRY_VALID))
+            slot = 0;
+        else if(!(bucket[1].info & CACHE_ENTRY_VALID))
+            slot = 1;
+        else {
+            int value_0 = bucket[0].value < 0 ? INT_MAX : bucket[0].value;
+            int value_1 = bucket[1].value < 0 ? INT_MAX : bucket[1].value;
+            int new_value = value < 0 ? INT_MAX : value;
+            slot = value_0 >= value_1 ? 0 : 1;
+
+            // keep both if the new entry is worse than the two stored ones
+            if(new_value > value_0 && new_value > value_1)
+                return;
+        }
+    }
+    write_entry(bucket[slot], key.check, value, prefs);
+}
+
+unsigned int HeuristicCache::get_heuristic_id(const string &heur_name) {
+    unsigned int id = 0;
+    for(int i = 0; i < heur_name.size(); i++)
+        id = mix_hash_bits(id ^ (unsigned char) heur_name[i]);
+    return id;
+}
+
+bool HeuristicCache::policy_from_string(const string &name, int &policy) {
+    if(name.compare("ALWAYS") == 0)
+        policy = REPLACE_ALWAYS;
+    else if(name.compare("HIGH_H") == 0)
+        policy = REPLACE_HIGH_H;
+    else {
+        cerr << "Invalid heuristic cache policy " << name << " entered"
+                << endl;
+        return false;
+    }
+    return true;
+}
+
+string HeuristicCache::policy_to_string(int policy) {
+    if(policy == REPLACE_ALWAYS)
+        return "ALWAYS";
+    return "HIGH_H";
+}
@@ -0,0 +1,70 @@
+#ifndef HEURISTIC_CACHE_H
+#define HEURISTIC_CACHE_H
+
+#include <string>
+#include <vector>
+
+#include "state_hash.h"
+
+class Operator;
+
+/**
+ * A transposition table of heuristic values that is shared by all search
+ * threads. It maps (state fingerprint, heuristic id) to the heuristic value,
+ * and a short summary of the preferred operators computed along with it.
+ *
+ * The table is a fixed-size array of two-entry buckets and is accessed
+ * without locks. Every entry stores the check half of the key XORed with
+ * its payload, so an entry that is torn by two threads writing it at the
+ * same time simply fails to verify and is reported as a miss.
+**/
+class HeuristicCache {
+public:
+    // replacement policies
+    enum {REPLACE_ALWAYS = 0, REPLACE_HIGH_H = 1};
+
+    // maximum number of preferred operators stored with an entry
+    enum {MAX_PREFS = 5};
+
+private:
+    struct Entry {
+        volatile unsigned int check;
+        volatile unsigned int info;
+        volatile int value;
+        volatile int prefs[MAX_PREFS];
+    };
+
+    Entry *entries;
+    unsigned int bucket_mask;
+    int policy;
+
+    static unsigned int compute_check(const Entry &entry);
+    static void write_entry(Entry &entry, unsigned int check, int value,
+            const std::vector<const Operator *> &prefs);
+
+public:
+    HeuristicCache(int size_kb, int replacement_policy);
+    ~HeuristicCache();
+
+    /**
+     * Looks up the entry stored for the given key. If need_prefs is set,
+     * entries whose preferred operators did not fit into the entry are
+     * treated as misses. On a hit, value and prefs are filled in.
+    **/
+    bool lookup(const StateHash &key, bool need_prefs, int &value,
+            std::vector<const Operator *> &prefs) const;
+
+    void store(const StateHash &key, int value,
+            const std::vector<const Operator *> &prefs);
+
+    int get_num_entries() const {return 2 * (bucket_mask + 1);}
+    int get_policy() const {return policy;}
+
+    // id used to separate the entries of different heuristics
+    static unsigned int get_heuristic_id(const std::string &heur_name);
+
+    static bool policy_from_string(const std::string &name, int &policy);
+    static std::string policy_to_string(int policy);
+};
+
+#endif
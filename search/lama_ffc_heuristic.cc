@@ -9,16 +9,13 @@ LAMA_FFC_Heuristic::~LAMA_FFC_Heuristic() {
 }
 
 int LAMA_FFC_Heuristic::compute_heuristic(const State &state) {
-
-    preferred_operators.clear();
-    ff_heur->clear_preferred_ops();
-    ff_heur->compute_heuristic(state);
-    ff_heur->get_preferred_operators(preferred_operators);
-
+    if(!ff_heur->compute_relaxed_plan(state, FFHeuristic::PLAN_COST, get_cutoff()))
+        return PRUNED;
+    if(ff_heur->get_relaxed_plan_cost() == DEAD_END)
+        return DEAD_END;
+
+    const vector<const Operator *> &helpful = ff_heur->get_helpful_actions();
+    for(int i = 0; i < helpful.size(); i++)
+        set_preferred(helpful[i]);
     return ff_heur->get_relaxed_plan_cost();
 }
-
-void LAMA_FFC_Heuristic::set_recompute_heuristic(const State &state){
-    ff_heur->set_recompute_heuristic(state);
-}
-
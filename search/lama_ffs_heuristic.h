@@ -17,7 +17,6 @@ public:
     ~LAMA_FFS_Heuristic();
     
     virtual int compute_heuristic(const State &state);
-    virtual void set_recompute_heuristic(const State &state);
     
     virtual std::string get_heuristic_name(){return "LAMA_FF_S";}
 };
@@ -26,7 +26,6 @@
 #include "globals.h"
 #include "operator.h"
 #include "search_engine.h"
-#include "successor_generator.h"
 
 LandmarksCountHeuristic::
 LandmarksCountHeuristic(const LandmarksGraph& l, 
@@ -51,27 +50,37 @@ void LandmarksCountHeuristic::set_recompute_heuristic(const State &state) {
     if(preferred_operators) {
         assert(ff_heuristic != 0);
         // Set additional goals for FF exploration
-        vector<pair<int, int> > lm_leaves;
-	hash_set<const LandmarkNode*, hash_pointer> result;
-	state.check_partial_plan(result);
-	collect_lm_leaves(ff_search_disjunctive_lms, result, lm_leaves);
+        lm_leaves.clear();
+	collect_lm_leaves(ff_search_disjunctive_lms, state.get_reached_lms(),
+			  lm_leaves);
         ff_heuristic->set_additional_goals(lm_leaves);
     }
 }
 
+StateHash LandmarksCountHeuristic::get_cache_key(const State &state) {
+    // The value depends on the landmarks reached on the path to the state.
+    // Instances that do not compute preferred operators must not share
+    // entries with those that do.
+    StateHash key = state.get_hash();
+    key.mix(state.get_reached_lms_hash());
+    key.mix(preferred_operators ? 1 : 0);
+    return key;
+}
+
 int LandmarksCountHeuristic::compute_heuristic(const State &state) {
     // Get landmarks that have been true at some point (put into 
     // "reached_lms") and their cost
-    hash_set<const LandmarkNode*, hash_pointer> reached_lms;
-    const int reached_lms_cost = state.check_partial_plan(reached_lms);
+    const LandmarkBitset& reached_lms = state.get_reached_lms();
+    const int reached_lms_cost = state.get_reached_lms_cost();
+    const int num_reached_lms = reached_lms.count();
     // Get landmarks that are needed again (of those in 
     // "reached_lms") because they have been made false in the meantime, 
     // but are goals or required by unachieved successors
-    hash_set<const LandmarkNode*, hash_pointer> needed_lms;
-    const int needed_lms_cost = state.get_needed_landmarks(needed_lms);
+    int num_needed_lms;
+    const int needed_lms_cost = state.get_needed_landmarks(num_needed_lms);
     assert(0 <= needed_lms_cost);
     assert(reached_lms_cost >= needed_lms_cost);
-    assert(reached_lms.size() >= needed_lms.size());
+    assert(num_reached_lms >= num_needed_lms);
 
     // Heuristic is total number (or cost, if action costs are used) of landmarks, 
     // minus the ones we have already achieved and do not need again
@@ -79,7 +88,7 @@ int LandmarksCountHeuristic::compute_heuristic(const State &state) {
     if(g_use_metric)
 	h = lgraph.cost_of_landmarks() - reached_lms_cost + needed_lms_cost;
     else
-	h = lgraph.number_of_landmarks() - reached_lms.size() + needed_lms.size();
+	h = lgraph.number_of_landmarks() - num_reached_lms + num_needed_lms;
     assert(h >= 0);
 
     // Test if goal has been reached even though the landmark heuristic is 
@@ -98,7 +107,7 @@ int LandmarksCountHeuristic::compute_heuristic(const State &state) {
         set<LandmarkNode*>::const_iterator it;
         for(it = my_nodes.begin(); it != my_nodes.end(); ++it) {
             const LandmarkNode& node = **it;
-            if(reached_lms.find(&node) == reached_lms.end())
+            if(!reached_lms.test(node.id))
                 lgraph.dump_node(&node);
         }
 	*/
@@ -120,6 +129,10 @@ int LandmarksCountHeuristic::compute_heuristic(const State &state) {
         cout << reached_lms_cost << " " << needed_lms_cost << endl;
     }
 
+    // the state is cut off anyway, so do not bother with helpful actions
+    if(h > get_cutoff())
+        return PRUNED;
+
     if(!preferred_operators || h == 0) {// no (need for) helpful actions, return
         return h;
     }
@@ -130,7 +143,7 @@ int LandmarksCountHeuristic::compute_heuristic(const State &state) {
     // to achieve one of the LM leaves.
 
     if(reached_lms_cost == lgraph.cost_of_landmarks() || 
-       !generate_helpful_actions(state, reached_lms)) {
+       !generate_helpful_actions(state, reached_lms, num_reached_lms)) {
 
 	assert(ff_heuristic != NULL);
 	// Use FF to plan to a landmark leaf
@@ -150,36 +163,37 @@ int LandmarksCountHeuristic::compute_heuristic(const State &state) {
 }
 
 void LandmarksCountHeuristic::
-collect_lm_leaves(bool disjunctive_lms,
-		  hash_set<const LandmarkNode*,hash_pointer>& reached_lms,
+collect_lm_leaves(bool disjunctive_lms, const LandmarkBitset& reached_lms,
 		  vector<pair<int, int> >& leaves) {
 
-    set<LandmarkNode*>::const_iterator it;
-    for(it = lgraph.get_nodes().begin(); it != lgraph.get_nodes().end(); it++) {
-        LandmarkNode* node_p = *it;
-    
-        if(!disjunctive_lms && node_p->disjunctive )
-            continue;
+    // leaves are the landmarks that are not reached, but all of whose
+    // parents are
+    for(int i = 0; i < lgraph.get_num_lm_words(); i++) {
+        unsigned int candidates = ~reached_lms.get_word(i);
+        if(!disjunctive_lms)
+            candidates &= lgraph.get_simple_lms_word(i);
+        while(candidates != 0) {
+            int id = i * LandmarkBitset::WORD_BITS + __builtin_ctz(candidates);
+            candidates &= candidates - 1;
+            if(id >= lgraph.number_of_landmarks())
+                break;
+            if(!lgraph.parents_reached(id, reached_lms))
+                continue;
 
-        if(reached_lms.find(node_p) == reached_lms.end() && 
-	   !check_node_orders_disobeyed(*node_p, reached_lms)) {
-
-            for(int i = 0; i < node_p->vars.size(); i++) { 
-                pair<int, int> node_prop = make_pair(node_p->vars[i], 
-						     node_p->vals[i]);
-                leaves.push_back(node_prop);
-            }
+            const LandmarkNode& node = lgraph.get_landmark(id);
+            for(int j = 0; j < node.vars.size(); j++)
+                leaves.push_back(make_pair(node.vars[j], node.vals[j]));
         }
     }
 }
 
 int LandmarksCountHeuristic::
 ff_search_lm_leaves(bool disjunctive_lms, const State& state,
-		    hash_set<const LandmarkNode*, hash_pointer>& reached_lms) {
+		    const LandmarkBitset& reached_lms) {
 
-    vector<pair<int, int> > leaves; 
-    collect_lm_leaves(disjunctive_lms, reached_lms, leaves);
-    if(ff_heuristic->plan_for_disj(leaves, state) == DEAD_END) {
+    lm_leaves.clear();
+    collect_lm_leaves(disjunctive_lms, reached_lms, lm_leaves);
+    if(ff_heuristic->plan_for_disj(lm_leaves, state) == DEAD_END) {
         return DEAD_END;
     }
     else return 0;
@@ -187,49 +201,33 @@ ff_search_lm_leaves(bool disjunctive_lms, const State& state,
 
 
 bool LandmarksCountHeuristic::
-check_node_orders_disobeyed(const LandmarkNode& node, 
-			    const hash_set<const LandmarkNode*, 
-			    hash_pointer>& reached) const {
-
-    const hash_map<LandmarkNode*, edge_type, hash_pointer >& parents = node.parents;
-    for(hash_map<LandmarkNode*, edge_type, hash_pointer >::const_iterator parent_it 
-            = parents.begin(); parent_it != parents.end(); parent_it++) {
-        const LandmarkNode& parent = *(parent_it->first);
-        if(reached.find(&parent) == reached.end()) {
-            return true;
-        }
-    }
-    return false;
-}
-
-
-bool LandmarksCountHeuristic::
-generate_helpful_actions(const State& state, 
-			 const hash_set<const LandmarkNode*, hash_pointer>& reached) {
+generate_helpful_actions(const State& state, const LandmarkBitset& reached,
+			 int num_reached) {
 
     /* Find actions that achieve new landmark leaves. If no such action exist, 
        return false. If a simple landmark can be achieved, return only operators 
        that achieve simple landmarks, else return operators that achieve 
        disjunctive landmarks */
-    vector<const Operator *> all_operators;
-    g_successor_generator->generate_applicable_ops(state, all_operators);
-    vector<const Operator *> ha_simple;
-    vector<const Operator *> ha_disj;
+    const vector<const Operator *> &all_operators = get_applicable_ops(state);
+    ha_simple.clear();
+    ha_disj.clear();
     
     for(int i = 0; i < all_operators.size(); i++) {
-	const vector<PrePost>& prepost = all_operators[i]->get_pre_post();
-	for(int j = 0; j < prepost.size(); j++) {
-	    if(!prepost[j].does_fire(state))
+	const Operator *op = all_operators[i];
+	const pair<int, int> *it = lgraph.operator_lms_begin(op->get_op_index());
+	const pair<int, int> *end = lgraph.operator_lms_end(op->get_op_index());
+	for(; it != end; ++it) {
+	    // unconditional effects fire whenever the operator is applicable
+	    if(it->first != -1 && !op->get_pre_post()[it->first].does_fire(state))
 		continue;
-	    const pair<int, int> varval = make_pair(prepost[j].var, prepost[j].post);
-	    const LandmarkNode* lm_p = lgraph.landmark_reached(varval);
-	    if(lm_p != 0 && landmark_is_interesting(state, reached, *lm_p)) {
+	    int lm_id = it->second;
+	    if(landmark_is_interesting(state, reached, num_reached, lm_id)) {
 		
-                if(lm_p->disjunctive) {
-                        ha_disj.push_back(all_operators[i]);
+                if(lgraph.get_landmark(lm_id).disjunctive) {
+                        ha_disj.push_back(op);
                 }
 		else 
-                    ha_simple.push_back(all_operators[i]);
+                    ha_simple.push_back(op);
 	    }
 	}
     }
@@ -250,18 +248,18 @@ generate_helpful_actions(const State& state,
 }
 
 bool LandmarksCountHeuristic::
-landmark_is_interesting(const State& s, 
-			const hash_set<const LandmarkNode*, hash_pointer>& reached, 
-			const LandmarkNode& lm) const {
+landmark_is_interesting(const State& s, const LandmarkBitset& reached,
+			int num_reached, int lm_id) const {
     /* A landmark is interesting if it hasn't been reached before and 
        its parents have all been reached, or if all landmarks have been 
        reached before, the LM is a goal, and it's not true at moment */
 
-    if(lgraph.number_of_landmarks() != reached.size()) { 
-	if(reached.find(&lm) != reached.end())
+    if(lgraph.number_of_landmarks() != num_reached) { 
+	if(reached.test(lm_id))
 	    return false;
 	else
-            return !check_node_orders_disobeyed(lm, reached);
+            return lgraph.parents_reached(lm_id, reached);
     }
+    const LandmarkNode& lm = lgraph.get_landmark(lm_id);
     return lm.is_goal() && !lm.is_true_in_state(s);
 }
@@ -38,34 +38,31 @@ class LandmarksCountHeuristic : public Heuristic {
     bool ff_search_disjunctive_lms;
 
     lm_set goal;
-    hash_set<const LandmarkNode*, hash_pointer> initial_state_landmarks;
 
-    void collect_lm_leaves(bool disjunctive_lms,
-			   hash_set<const LandmarkNode*,hash_pointer>& result,
+    // buffers of an evaluation, kept so that evaluations do not allocate
+    vector<pair<int, int> > lm_leaves;
+    vector<const Operator *> ha_simple;
+    vector<const Operator *> ha_disj;
+
+    void collect_lm_leaves(bool disjunctive_lms, const LandmarkBitset& reached,
 			   vector<pair<int, int> >& leaves);
     int ff_search_lm_leaves(bool disjunctive_lms, const State& state,
-			    hash_set<const LandmarkNode*, hash_pointer>& result);
-  
-    bool check_node_orders_disobeyed(const LandmarkNode& node, 
-				     const hash_set<const LandmarkNode*, 
-				     hash_pointer>& reached) const;
- 
-    void add_node_children(const LandmarkNode& node, 
-			   const hash_set<const LandmarkNode*, 
-			   hash_pointer>& reached) const;
+			    const LandmarkBitset& reached);
 
-    bool landmark_is_interesting(const State& s, const hash_set<const LandmarkNode*, 
-				 hash_pointer>& reached, const LandmarkNode& lm) const;
+    bool landmark_is_interesting(const State& s, const LandmarkBitset& reached,
+				 int num_reached, int lm_id) const;
     bool generate_helpful_actions(const State& state, 
-				  const hash_set<const LandmarkNode*, hash_pointer>& reached);
+				  const LandmarkBitset& reached, int num_reached);
 protected:
     virtual int compute_heuristic(const State &state);
+    virtual StateHash get_cache_key(const State &state);
 public:
     LandmarksCountHeuristic(const LandmarksGraph& l, //const BestFirstSearchEngine& s,
                             bool use_preferred_operators, FFHeuristic *ff_heur);
     ~LandmarksCountHeuristic() {}
     virtual void set_recompute_heuristic(const State &state);
     virtual bool dead_ends_are_reliable() {return false;}
+    virtual bool uses_reached_landmarks() {return true;}
     virtual string get_heuristic_name() {return "Landmarks Count";}
 };
 
@@ -36,6 +36,7 @@
 #include "state.h"
 #include "globals.h"
 #include "ff_heuristic.h"
+#include "thread_pool.h"
 
 using namespace std;
 
@@ -157,6 +158,13 @@ LandmarkNode& LandmarksGraph::landmark_add_disjunctive(const set<pair<int, int>
 
 void LandmarksGraph::generate() {
     //cout << "generating landmarks" << endl;
+
+    // one explorer per thread, so relaxed explorations can run in parallel
+    explorers.push_back(ff_heur);
+    int num_threads = g_thread_pool != NULL ? g_thread_pool->get_num_threads() : 1;
+    while(explorers.size() < num_threads)
+        explorers.push_back(new FFHeuristic);
+
     generate_landmarks();
     if(reasonable_orders) {
         cout << "approx. reasonable orders" << endl;
@@ -166,8 +174,218 @@ void LandmarksGraph::generate() {
     }
     mk_acyclic_graph();
     landmarks_cost = calculate_lms_cost();
+    compile();
+
+    for(int i = 1; i < explorers.size(); i++)
+        delete explorers[i];
+    explorers.resize(1);
 }
 
+void LandmarksGraph::compile() {
+/* Number the landmarks in the iteration order of the node set and store the
+   orderings and the fact and operator lookups in flat arrays, so that the
+   landmark heuristic and the states can work on bitsets instead of hash sets.
+*/
+    assert(nodes.size() == landmarks_count);
+    landmarks_by_id.assign(nodes.begin(), nodes.end());
+    for(int i = 0; i < landmarks_by_id.size(); i++)
+        landmarks_by_id[i]->id = i;
+
+    lm_words = LandmarkBitset::num_words(landmarks_count);
+    parent_masks.assign(landmarks_count * lm_words, 0);
+    gn_child_masks.assign(landmarks_count * lm_words, 0);
+    simple_lms_mask.assign(lm_words, 0);
+    const int word_bits = LandmarkBitset::WORD_BITS;
+    for(int i = 0; i < landmarks_by_id.size(); i++) {
+        const LandmarkNode &node = *landmarks_by_id[i];
+        if(!node.disjunctive)
+            simple_lms_mask[i / word_bits] |= 1U << (i % word_bits);
+
+        hash_map<LandmarkNode*, edge_type, hash_pointer>::const_iterator it;
+        for(it = node.parents.begin(); it != node.parents.end(); ++it) {
+            int parent = it->first->id;
+            parent_masks[i * lm_words + parent / word_bits] |=
+                1U << (parent % word_bits);
+        }
+        for(it = node.children.begin(); it != node.children.end(); ++it) {
+            if(it->second != gn)
+                continue;
+            int child = it->first->id;
+            gn_child_masks[i * lm_words + child / word_bits] |=
+                1U << (child % word_bits);
+        }
+    }
+
+    fact_offset.clear();
+    int num_facts = 0;
+    for(int var = 0; var < g_variable_domain.size(); var++) {
+        fact_offset.push_back(num_facts);
+        num_facts += g_variable_domain[var];
+    }
+    fact_to_lm.assign(num_facts, -1);
+    for(int var = 0; var < g_variable_domain.size(); var++) {
+        for(int val = 0; val < g_variable_domain[var]; val++) {
+            const LandmarkNode *node_p = landmark_reached(make_pair(var, val));
+            if(node_p != 0)
+                fact_to_lm[fact_offset[var] + val] = node_p->id;
+        }
+    }
+
+    operator_lms_start.clear();
+    operator_lms.clear();
+    for(int i = 0; i < g_operators.size(); i++) {
+        operator_lms_start.push_back(operator_lms.size());
+        const vector<PrePost> &prepost = g_operators[i].get_pre_post();
+        for(int j = 0; j < prepost.size(); j++) {
+            int id = get_landmark_id(prepost[j].var, prepost[j].post);
+            if(id == -1)
+                continue;
+            int effect = prepost[j].cond.empty() ? -1 : j;
+            operator_lms.push_back(make_pair(effect, id));
+        }
+    }
+    operator_lms_start.push_back(operator_lms.size());
+}
+
+
+/* The graph file is a sequence of ints:
+     magic, version, fingerprint size, fingerprint,
+     number of landmarks, cost of landmarks,
+     for every landmark: disjunctive, in_goal, min_cost, number of facts,
+                         (var, val) of every fact,
+     number of edges, (from, to, edge type) of every edge,
+     magic.
+   Landmarks are numbered by their ids. The forward orders of the nodes are
+   only needed while generating and are not stored. */
+static const int LM_GRAPH_MAGIC = 0x4c4d4731; // "LMG1"
+static const int LM_GRAPH_VERSION = 1;
+
+void LandmarksGraph::save(const string &file,
+                          const vector<unsigned int> &fingerprint) const {
+    vector<int> data;
+    data.push_back(LM_GRAPH_MAGIC);
+    data.push_back(LM_GRAPH_VERSION);
+    data.push_back(fingerprint.size());
+    data.insert(data.end(), fingerprint.begin(), fingerprint.end());
+
+    data.push_back(landmarks_count);
+    data.push_back(landmarks_cost);
+    int num_edges = 0;
+    for(int i = 0; i < landmarks_by_id.size(); i++) {
+        const LandmarkNode &node = *landmarks_by_id[i];
+        data.push_back(node.disjunctive);
+        data.push_back(node.in_goal);
+        data.push_back(node.min_cost);
+        data.push_back(node.vars.size());
+        for(int j = 0; j < node.vars.size(); j++) {
+            data.push_back(node.vars[j]);
+            data.push_back(node.vals[j]);
+        }
+        num_edges += node.children.size();
+    }
+    data.push_back(num_edges);
+    for(int i = 0; i < landmarks_by_id.size(); i++) {
+        const LandmarkNode &node = *landmarks_by_id[i];
+        hash_map<LandmarkNode*, edge_type, hash_pointer>::const_iterator it;
+        for(it = node.children.begin(); it != node.children.end(); ++it) {
+            data.push_back(i);
+            data.push_back(it->first->id);
+            data.push_back(it->second);
+        }
+    }
+    data.push_back(LM_GRAPH_MAGIC);
+
+    // write to a temporary file first, so that a planner started at the same
+    // time never reads a partly written graph
+    string tmp_file = file + ".tmp";
+    ofstream out(tmp_file.c_str(), ios::binary);
+    out.write(reinterpret_cast<const char *>(&data[0]), data.size() * sizeof(int));
+    out.close();
+    if(!out || rename(tmp_file.c_str(), file.c_str()) != 0) {
+        cout << "Could not write landmarks graph to " << file << endl;
+        remove(tmp_file.c_str());
+    }
+}
+
+bool LandmarksGraph::load(const string &file,
+                          const vector<unsigned int> &fingerprint) {
+    assert(nodes.empty());
+    ifstream in(file.c_str(), ios::binary);
+    if(!in.is_open())
+        return false;
+    in.seekg(0, ios::end);
+    int num_ints = in.tellg() / sizeof(int);
+    in.seekg(0, ios::beg);
+    if(num_ints < 4 + fingerprint.size())
+        return false;
+    vector<int> data(num_ints);
+    in.read(reinterpret_cast<char *>(&data[0]), num_ints * sizeof(int));
+    if(!in || data[0] != LM_GRAPH_MAGIC || data[1] != LM_GRAPH_VERSION ||
+       data[2] != fingerprint.size() || data.back() != LM_GRAPH_MAGIC)
+        return false;
+    int pos = 3;
+    for(int i = 0; i < fingerprint.size(); i++)
+        if(data[pos++] != int(fingerprint[i]))
+            return false;
+
+    /* The fingerprint makes a mismatch very unlikely, but the file is still
+       checked completely before the graph is built from it. */
+    int end = num_ints - 1;
+    if(pos + 3 > end)
+        return false;
+    int count = data[pos++];
+    int cost = data[pos++];
+    int start = pos;
+    for(int i = 0; i < count; i++) {
+        if(pos + 4 > end)
+            return false;
+        int num_facts = data[pos + 3];
+        pos += 4;
+        if(num_facts < 1 || pos + 2 * num_facts > end)
+            return false;
+        for(int j = 0; j < num_facts; j++, pos += 2) {
+            int var = data[pos];
+            if(var < 0 || var >= g_variable_domain.size() ||
+               data[pos + 1] < 0 || data[pos + 1] >= g_variable_domain[var])
+                return false;
+        }
+    }
+    if(pos >= end || pos + 1 + 3 * data[pos] != end)
+        return false;
+    for(int i = pos + 1; i < end; i += 3)
+        if(data[i] < 0 || data[i] >= count || data[i + 1] < 0 ||
+           data[i + 1] >= count || data[i] == data[i + 1])
+            return false;
+
+    vector<LandmarkNode *> by_id;
+    pos = start;
+    for(int i = 0; i < count; i++) {
+        bool disjunctive = data[pos];
+        bool in_goal = data[pos + 1];
+        int min_cost = data[pos + 2];
+        int num_facts = data[pos + 3];
+        pos += 4;
+        set<pair<int, int> > facts;
+        for(int j = 0; j < num_facts; j++, pos += 2)
+            facts.insert(make_pair(data[pos], data[pos + 1]));
+        LandmarkNode &node = disjunctive ? landmark_add_disjunctive(facts) :
+            landmark_add_simple(*facts.begin());
+        node.in_goal = in_goal;
+        node.min_cost = min_cost;
+        by_id.push_back(&node);
+    }
+    int num_edges = data[pos++];
+    for(int i = 0; i < num_edges; i++, pos += 3) {
+        LandmarkNode *from = by_id[data[pos]];
+        LandmarkNode *to = by_id[data[pos + 1]];
+        edge_type type = edge_type(data[pos + 2]);
+        from->children[to] = type;
+        to->parents[from] = type;
+    }
+    landmarks_cost = cost;
+    compile();
+    return true;
+}
 
 void LandmarksGraph::read_external_inconsistencies() {
 /* Read inconsistencies that were found by translator from separate file. Note: this
@@ -253,7 +471,8 @@ void LandmarksGraph::read_external_inconsistencies() {
     }
 }
 
-bool LandmarksGraph::relaxed_task_solvable(vector<vector<int> >& lvl_var, 
+bool LandmarksGraph::relaxed_task_solvable(FFHeuristic *explorer,
+                                           vector<vector<int> >& lvl_var, 
 					   vector<hash_map<pair<int, int>, int, 
 					   hash_int_pair> >& lvl_op, 
 					   bool level_out,
@@ -292,8 +511,8 @@ bool LandmarksGraph::relaxed_task_solvable(vector<vector<int> >& lvl_var,
 	    exclude_props.push_back(make_pair(exclude->vars[i], exclude->vals[i]));
     }
     // Do relaxed exploration in ff_heuristic class
-    ff_heur->compute_reachability_with_excludes(lvl_var, lvl_op, level_out, exclude_props, exclude_ops,
-						  compute_lvl_op);
+    explorer->compute_reachability_with_excludes(lvl_var, lvl_op, level_out, exclude_props, exclude_ops,
+						   compute_lvl_op);
     
     // Test whether all goal propositions have a level of less than INT_MAX
     for(int i = 0; i < g_goal.size(); i++)
@@ -554,6 +773,23 @@ inline static bool _in_goal(const pair<int,int>& l) {
     return false;
 }
 
+class ReasonableOrdersTask : public ParallelTask {
+    LandmarksGraph &lgraph;
+    const vector<LandmarkNode*> &targets;
+    bool obedient_orders;
+public:
+    vector<vector<pair<LandmarkNode*, edge_type> > > orders;
+
+    ReasonableOrdersTask(LandmarksGraph &g, const vector<LandmarkNode*> &t,
+                         bool obedient) :
+        lgraph(g), targets(t), obedient_orders(obedient), orders(t.size()) {}
+
+    virtual void run(int item, int) {
+        lgraph.collect_reasonable_orders(targets[item], obedient_orders,
+                                         orders[item]);
+    }
+};
+
 void LandmarksGraph::approximate_reasonable_orders(bool obedient_orders) {
 /* Approximate reasonable and obedient reasonable orders according to Hoffmann et al. If flag
    "obedient_orders" is true, we calculate obedient reasonable orders, otherwise reasonable orders. 
@@ -563,61 +799,79 @@ void LandmarksGraph::approximate_reasonable_orders(bool obedient_orders) {
    predecessor "parent" of node2, then parent and all predecessors of parent can be ordered reasonably 
    before node_p if they interfere with node_p.
  */
-    for(set<LandmarkNode*>::iterator it = nodes.begin(); it != nodes.end(); it++) {
-        LandmarkNode* node_p = *it;
-        if(node_p->disjunctive)
-            continue;
-        pair<int, int> node_prop = make_pair(node_p->vars[0], node_p->vals[0]);
-
-        if(!obedient_orders &&_in_goal(node_prop)) {
-            for(set<LandmarkNode*>::iterator it2 = nodes.begin(); it2 != nodes.end(); it2++) {
-                LandmarkNode* node2_p = *it2;
-                if(node2_p->disjunctive)
-                    continue;
-                pair<int, int> node2_prop = make_pair(node2_p->vars[0], node2_p->vals[0]);
-                if(node_prop != node2_prop && interferes(node2_p, node_p)) {
-		    edge_add(*node2_p, *node_p, r);
-                }
+    // Adding reasonable orders never changes the edges that the search for
+    // further reasonable orders looks at, so the candidates of all nodes are
+    // collected in parallel and then added in the serial order.
+    vector<LandmarkNode*> targets(nodes.begin(), nodes.end());
+    ReasonableOrdersTask task(*this, targets, obedient_orders);
+    if(g_thread_pool != NULL)
+        g_thread_pool->run(task, targets.size());
+    else
+        for(int i = 0; i < targets.size(); i++)
+            task.run(i, 0);
+
+    for(int i = 0; i < targets.size(); i++)
+        for(int j = 0; j < task.orders[i].size(); j++)
+            edge_add(*task.orders[i][j].first, *targets[i], task.orders[i][j].second);
+}
+
+void LandmarksGraph::collect_reasonable_orders(LandmarkNode* node_p,
+                                               bool obedient_orders,
+                                               vector<pair<LandmarkNode*, edge_type> >& orders) {
+/* Collect the nodes that can be ordered reasonably (or obedient reasonably) before
+   node_p, with the type of the order, in the order in which they are found.
+ */
+    if(node_p->disjunctive)
+        return;
+    pair<int, int> node_prop = make_pair(node_p->vars[0], node_p->vals[0]);
+
+    if(!obedient_orders &&_in_goal(node_prop)) {
+        for(set<LandmarkNode*>::iterator it2 = nodes.begin(); it2 != nodes.end(); it2++) {
+            LandmarkNode* node2_p = *it2;
+            if(node2_p->disjunctive)
+                continue;
+            pair<int, int> node2_prop = make_pair(node2_p->vars[0], node2_p->vals[0]);
+            if(node_prop != node2_prop && interferes(node2_p, node_p)) {
+                orders.push_back(make_pair(node2_p, r));
             }
         }
-        else if(!node_p->is_true_in_state(*g_initial_state)) {
-            // Collect candidates for reasonable orders in "interesting nodes". 
-            // Use hash set to filter duplicates.
-            hash_set<LandmarkNode*, hash_pointer> interesting_nodes(g_variable_name.size());
-            for(hash_map<LandmarkNode*, edge_type, hash_pointer >::iterator 
-                    it = node_p->children.begin(); it != node_p->children.end(); it++) {
-                if(it->second == gn) { // found node2: node_p ->_gn node2
-                    LandmarkNode& node2 = *(it->first);
-                    for(hash_map<LandmarkNode*, edge_type, hash_pointer>::iterator 
-                            it2 = node2.parents.begin(); it2 != node2.parents.end(); it2++) { // find parent
-                        edge_type& edge = it2->second;
-                        LandmarkNode& parent = *(it2->first);
-			if(parent.disjunctive)
-                            continue;
-                        if( (edge == gn || edge == n || edge == ln || (obedient_orders && edge == r)) && 
-                            &parent != node_p) { // find predecessors or parent and collect in "interesting nodes" 
-                            interesting_nodes.insert(&parent);
-                            collect_ancestors(interesting_nodes, parent, obedient_orders);
-                        }
+    }
+    else if(!node_p->is_true_in_state(*g_initial_state)) {
+        // Collect candidates for reasonable orders in "interesting nodes". 
+        // Use hash set to filter duplicates.
+        hash_set<LandmarkNode*, hash_pointer> interesting_nodes(g_variable_name.size());
+        for(hash_map<LandmarkNode*, edge_type, hash_pointer >::iterator 
+                it = node_p->children.begin(); it != node_p->children.end(); it++) {
+            if(it->second == gn) { // found node2: node_p ->_gn node2
+                LandmarkNode& node2 = *(it->first);
+                for(hash_map<LandmarkNode*, edge_type, hash_pointer>::iterator 
+                        it2 = node2.parents.begin(); it2 != node2.parents.end(); it2++) { // find parent
+                    edge_type& edge = it2->second;
+                    LandmarkNode& parent = *(it2->first);
+                    if(parent.disjunctive)
+                        continue;
+                    if( (edge == gn || edge == n || edge == ln || (obedient_orders && edge == r)) && 
+                        &parent != node_p) { // find predecessors or parent and collect in "interesting nodes" 
+                        interesting_nodes.insert(&parent);
+                        collect_ancestors(interesting_nodes, parent, obedient_orders);
                     }
                 }
             }
-	    // Insert reasonable orders between those members of "interesting nodes" that interfere 
-	    // with node_p. 
-            for(hash_set<LandmarkNode*, hash_pointer>::iterator 
-                    it3 = interesting_nodes.begin(); it3 != interesting_nodes.end(); it3++) {
-                if((*it3)->disjunctive)
-                    continue;
-                pair<int, int> it_prop = make_pair((*it3)->vars[0], (*it3)->vals[0]);
-                if(it_prop != node_prop && interferes(*it3, node_p)) {
-		    if(!obedient_orders)
-			edge_add(**it3, *node_p, r);
-		    else
-			edge_add(**it3, *node_p, o_r);
-		}
+        }
+        // Insert reasonable orders between those members of "interesting nodes" that interfere 
+        // with node_p. 
+        for(hash_set<LandmarkNode*, hash_pointer>::iterator 
+                it3 = interesting_nodes.begin(); it3 != interesting_nodes.end(); it3++) {
+            if((*it3)->disjunctive)
+                continue;
+            pair<int, int> it_prop = make_pair((*it3)->vars[0], (*it3)->vals[0]);
+            if(it_prop != node_prop && interferes(*it3, node_p)) {
+                if(!obedient_orders)
+                    orders.push_back(make_pair(*it3, r));
+                else
+                    orders.push_back(make_pair(*it3, o_r));
             }
         }
-
     }
 }
 
@@ -41,7 +41,7 @@ enum edge_type {n = 4, gn = 3, r = 1, o_r = 0, ln = 2};
 class LandmarkNode {
 public:
     LandmarkNode(vector<int>& variables, vector<int>& values, bool disj) : 
-        vars(variables), vals(values), disjunctive(disj), in_goal(false), min_cost(1) {}
+        vars(variables), vals(values), disjunctive(disj), in_goal(false), min_cost(1), id(-1) {}
     vector<int> vars;
     vector<int> vals;
     bool disjunctive; 	    
@@ -49,6 +49,7 @@ public:
     hash_map<LandmarkNode*, edge_type, hash_pointer> children;
     bool in_goal;
     int min_cost; // minimal cost of achieving operators
+    int id; // dense index assigned by LandmarksGraph::compile()
 
     hash_set<pair<int, int>, hash_int_pair> forward_orders;
   
@@ -90,6 +91,14 @@ public:
     void use_reasonable_orders() {reasonable_orders = true;}
 
     void generate();
+
+    // Writes the generated graph to file, tagged with the given fingerprint
+    // of the task. load() reads such a file back into an empty graph instead
+    // of generating it and returns false if the file is missing or was
+    // written for another fingerprint.
+    void save(const string &file, const vector<unsigned int> &fingerprint) const;
+    bool load(const string &file, const vector<unsigned int> &fingerprint);
+
     bool simple_landmark_exists(const pair<int, int>& lm) const;
     bool disj_landmark_exists(const set<pair<int, int> >& lm) const;
     bool landmark_exists(const pair<int, int>& lm) const; 
@@ -126,6 +135,39 @@ public:
         return nodes;
     }
 
+    // Compiled form of the graph, available once generate() is done. Every
+    // landmark has an id in [0, number_of_landmarks()) and orderings are
+    // kept as bitmasks over these ids.
+    inline int get_landmark_id(int var, int val) const {
+        return fact_to_lm[fact_offset[var] + val];
+    }
+    inline const LandmarkNode& get_landmark(int id) const {
+        return *landmarks_by_id[id];
+    }
+    inline int get_num_lm_words() const {
+        return lm_words;
+    }
+    inline unsigned int get_simple_lms_word(int word) const {
+        return simple_lms_mask[word];
+    }
+    // true if all parents of the landmark are in reached
+    inline bool parents_reached(int id, const LandmarkBitset& reached) const {
+        return reached.contains_all(&parent_masks[id * lm_words]);
+    }
+    // landmarks that the effects of operator op_no achieve, as pairs of the
+    // effect index (-1 if the effect is unconditional) and the landmark id
+    inline const pair<int, int> *operator_lms_begin(int op_no) const {
+        return operator_lms.empty() ? 0 : &operator_lms[0] + operator_lms_start[op_no];
+    }
+    inline const pair<int, int> *operator_lms_end(int op_no) const {
+        return operator_lms_begin(op_no) +
+            (operator_lms_start[op_no + 1] - operator_lms_start[op_no]);
+    }
+    // true if all greedy-necessary children of the landmark are in reached
+    inline bool gn_children_reached(int id, const LandmarkBitset& reached) const {
+        return reached.contains_all(&gn_child_masks[id * lm_words]);
+    }
+
     inline const vector<int>& get_operators_including_eff(const pair<int, int>& eff) const {
         return operators_eff_lookup[eff.first][eff.second];
     }
@@ -147,7 +189,11 @@ private:
     vector<vector<vector<int> > > operators_eff_lookup;
     vector<vector<vector<int> > > operators_pre_lookup;
     void generate_operators_lookups();
+    void compile();
     void approximate_reasonable_orders(bool obedient_orders);
+    void collect_reasonable_orders(LandmarkNode* node_p, bool obedient_orders,
+                                   vector<pair<LandmarkNode*, edge_type> >& orders);
+    friend class ReasonableOrdersTask;
     void mk_acyclic_graph();
     int loop_acyclic_graph(LandmarkNode& lmn, 
                            hash_set<LandmarkNode*, hash_pointer>& acyclic_node_set);
@@ -165,9 +211,26 @@ private:
     bool reasonable_orders;
 
     FFHeuristic *ff_heur;
+
+    // compiled graph, see compile()
+    vector<LandmarkNode*> landmarks_by_id;
+    int lm_words;
+    vector<unsigned int> parent_masks;
+    vector<unsigned int> gn_child_masks;
+    vector<unsigned int> simple_lms_mask;
+    vector<int> fact_offset;
+    vector<int> fact_to_lm;
+    vector<int> operator_lms_start;
+    vector<pair<int, int> > operator_lms;
     vector<vector<set<pair<int, int> > > > inconsistent_facts;
 
+    // relaxed explorers for the threads of g_thread_pool, the first one
+    // is ff_heur
+    vector<FFHeuristic *> explorers;
+
 protected:
+    FFHeuristic *get_explorer(int thread) const {return explorers[thread];}
+
 
     set<LandmarkNode*> nodes;
 
@@ -189,7 +252,18 @@ protected:
 	vector<hash_map<pair<int, int>, int, hash_int_pair> > lvl_op;
         return relaxed_task_solvable(lvl_var, lvl_op, level_out, exclude, compute_lvl_op);
     }
-    bool relaxed_task_solvable(vector<vector<int> >& lvl_var,
+    inline bool relaxed_task_solvable(vector<vector<int> >& lvl_var,
+			       vector<hash_map<pair<int, int>, int, hash_int_pair> >& lvl_op,
+                               bool level_out, 
+                               const LandmarkNode* exclude,
+			       bool compute_lvl_op = false) const {
+        return relaxed_task_solvable(ff_heur, lvl_var, lvl_op, level_out, exclude,
+                                     compute_lvl_op);
+    }
+    // as above, exploring with the given FFHeuristic so that several
+    // explorations can run in parallel
+    bool relaxed_task_solvable(FFHeuristic *explorer,
+                               vector<vector<int> >& lvl_var,
 			       vector<hash_map<pair<int, int>, int, hash_int_pair> >& lvl_op,
                                bool level_out, 
                                const LandmarkNode* exclude,
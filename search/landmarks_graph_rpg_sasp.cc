@@ -31,6 +31,7 @@
 #include "state.h"
 #include "globals.h"
 #include "domain_transition_graph.h"
+#include "thread_pool.h"
 
 using namespace __gnu_cxx;
 
@@ -365,14 +366,94 @@ compute_disjunctive_preconditions(vector<set<pair<int, int> > >& disjunctive_pre
 }
 
 void LandmarksGraphNew::
-compute_predecessor_information(LandmarkNode* bp,
+compute_predecessor_information(const LandmarkNode* bp,
                                 vector<vector<int> >& lvl_var,
-				vector<hash_map<pair<int, int>, int, hash_int_pair> >& lvl_op) {
+				vector<hash_map<pair<int, int>, int, hash_int_pair> >& lvl_op,
+				int thread) const {
     /* Collect information at what time step propositions can be reached
        (in lvl_var) in a relaxed plan that excludes bp, and similarly 
        when operators can be applied (in lvl_op).  */
 
-    relaxed_task_solvable(lvl_var, lvl_op, true, bp);
+    relaxed_task_solvable(get_explorer(thread), lvl_var, lvl_op, true, bp);
+}
+
+class ExplorationTask : public ParallelTask {
+    const LandmarksGraphNew &lgraph;
+    const vector<LandmarkNode*> &landmarks;
+    const vector<LandmarksGraphNew::Exploration*> &results;
+public:
+    ExplorationTask(const LandmarksGraphNew &g, const vector<LandmarkNode*> &l,
+                    const vector<LandmarksGraphNew::Exploration*> &r) :
+        lgraph(g), landmarks(l), results(r) {}
+
+    virtual void run(int item, int thread) {
+        lgraph.explore(landmarks[item], thread, *results[item]);
+    }
+};
+
+void LandmarksGraphNew::explore(const LandmarkNode* bp, int thread,
+                                Exploration& result) const {
+    /* Do the relaxed explorations that processing bp needs. They only depend
+       on the facts of bp, not on the rest of the landmarks graph. */
+    result.vars = bp->vars;
+    result.vals = bp->vals;
+    vector<hash_map<pair<int, int>, int, hash_int_pair> > lvl_op;
+    compute_predecessor_information(bp, result.lvl_var, lvl_op, thread);
+    find_forward_orders(result.lvl_var, bp, result.forward_orders);
+}
+
+void LandmarksGraphNew::explore_open_landmarks(LandmarkNode* bp) {
+    /* Explore bp and the next open landmarks that have not been explored yet
+       in parallel. The entries of "explorations" are created and looked up
+       before the threads start, so that the map is not modified while they
+       run and each of them only writes to its own entry. */
+    const int batch_size = 4 * g_thread_pool->get_num_threads();
+    vector<LandmarkNode*> batch;
+    batch.push_back(bp);
+    for(list<LandmarkNode*>::const_iterator it = open_landmarks.begin();
+        it != open_landmarks.end() && batch.size() < batch_size; it++) {
+        if(*it == bp || (*it)->is_true_in_state(*g_initial_state) ||
+           explorations.find(*it) != explorations.end())
+            continue;
+        batch.push_back(*it);
+    }
+    vector<Exploration*> results;
+    for(int i = 0; i < batch.size(); i++) {
+        Exploration &entry = explorations[batch[i]];
+        entry = Exploration();
+        results.push_back(&entry);
+    }
+    // hash_map nodes do not move when the map grows, so all pointers are valid.
+
+    ExplorationTask task(*this, batch, results);
+    g_thread_pool->run(task, batch.size());
+}
+
+void LandmarksGraphNew::get_exploration(LandmarkNode* bp,
+                                        vector<vector<int> >& lvl_var,
+                                        vector<pair<int, int> >& forward_orders) {
+    if(g_thread_pool == NULL || g_thread_pool->get_num_threads() == 1) {
+        vector<hash_map<pair<int, int>, int, hash_int_pair> > lvl_op;
+        compute_predecessor_information(bp, lvl_var, lvl_op);
+        find_forward_orders(lvl_var, bp, forward_orders);
+        return;
+    }
+
+    hash_map<const LandmarkNode*, Exploration, hash_pointer>::iterator it =
+        explorations.find(bp);
+    if(it != explorations.end() &&
+       (it->second.vars != bp->vars || it->second.vals != bp->vals)) {
+        // landmark changed since it was explored
+        explorations.erase(it);
+        it = explorations.end();
+    }
+    if(it == explorations.end()) {
+        explore_open_landmarks(bp);
+        it = explorations.find(bp);
+    }
+    lvl_var.swap(it->second.lvl_var);
+    forward_orders.swap(it->second.forward_orders);
+    explorations.erase(it);
 }
 
 void LandmarksGraphNew::generate_landmarks() {
@@ -393,8 +474,10 @@ void LandmarksGraphNew::generate_landmarks() {
 	    // relaxed plan that propositions are achieved (in lvl_var) and operators
 	    // applied (in lvl_ops).
 	    vector<vector<int> > lvl_var;
-            vector<hash_map<pair<int, int>, int, hash_int_pair> > lvl_op;
-	    compute_predecessor_information(bp, lvl_var, lvl_op);
+	    vector<pair<int, int> > forward_orders;
+	    vector<int> explored_vars = bp->vars;
+	    vector<int> explored_vals = bp->vals;
+	    get_exploration(bp, lvl_var, forward_orders);
 	    // Use this information to determine all operators that can possibly achieve bp 
             // for the first time, and collect any precondition propositions that all such 
 	    // operators share (if there are any).
@@ -405,7 +488,13 @@ void LandmarksGraphNew::generate_landmarks() {
                 found_lm_and_order(*it, *bp, gn);
             }
             // Extract additional orders from relaxed planning graph and DTG.
-	    approximate_lookahead_orders(lvl_var, bp);
+	    // The forward orders depend on the facts of bp, which may just have
+	    // changed if bp was turned from a disjunctive into a simple landmark.
+	    if(bp->vars != explored_vars || bp->vals != explored_vals) {
+		forward_orders.clear();
+		find_forward_orders(lvl_var, bp, forward_orders);
+	    }
+	    approximate_lookahead_orders(lvl_var, bp, forward_orders);
 	    // Use the information about possibly achieving operators of bp to set its min cost.
 	    bp->min_cost = min_cost_for_landmark(bp, lvl_var);
 
@@ -418,19 +507,23 @@ void LandmarksGraphNew::generate_landmarks() {
 		}
         }
     }
+    // Entries are erased when they are used, but drop any that were not.
+    explorations.clear();
     add_lm_forward_orders();
 }
 
 
 void LandmarksGraphNew::approximate_lookahead_orders(const vector<vector<int> >& lvl_var, 
-						     LandmarkNode* lmp) {
+						     LandmarkNode* lmp,
+						     const vector<pair<int, int> >& forward_orders) {
 
     // Find all var-val pairs that can only be reached after the landmark 
     // (according to relaxed plan graph as captured in lvl_var)
     // the result is saved in the node member variable forward_orders, and will be
     // used later, when the phase of finding LMs has ended (because at the 
     // moment we don't know which of these var-val pairs will be LMs). 
-    find_forward_orders(lvl_var, lmp);
+    // They have been found by find_forward_orders.
+    lmp->forward_orders.insert(forward_orders.begin(), forward_orders.end());
 
     // Use domain transition graphs to find further orders. Only possible if lmp is
     // a simple landmark.
@@ -495,10 +588,12 @@ bool LandmarksGraphNew::domain_connectivity(const pair<int, int>& landmark,
 }
 
 void LandmarksGraphNew::find_forward_orders(const vector<vector<int> >& lvl_var, 
-					    LandmarkNode* lmp) {
+					    const LandmarkNode* lmp,
+					    vector<pair<int, int> >& result) const {
     /* lmp is ordered before any var-val pair that cannot be reached before lmp according to 
        relaxed planning graph (as captured in lvl_var).
-       These orders are saved in the node member variable "forward_orders".
+       These orders are collected in "result" and later saved in the node member 
+       variable "forward_orders".
     */
     for(int i = 0; i < g_variable_domain.size(); i++)
 	for(int j = 0; j <  g_variable_domain[i]; j++) {
@@ -527,7 +622,7 @@ void LandmarksGraphNew::find_forward_orders(const vector<vector<int> >& lvl_var,
 		    insert = false;
 	    }
 	    if(insert)
-		lmp->forward_orders.insert(make_pair(i,j));
+		result.push_back(make_pair(i,j));
 	}
 }
 
@@ -30,8 +30,27 @@
 class LandmarksGraphNew : public LandmarksGraph {
 
     list<LandmarkNode*> open_landmarks;
+
+    // Relaxed explorations done in parallel for landmarks that are still
+    // open. They are only valid while the facts of the landmark are the ones
+    // that were explored.
+    struct Exploration {
+        vector<int> vars;
+        vector<int> vals;
+        vector<vector<int> > lvl_var;
+        vector<pair<int, int> > forward_orders;
+    };
+    hash_map<const LandmarkNode*, Exploration, hash_pointer> explorations;
+    friend class ExplorationTask;
+
+    void explore(const LandmarkNode* bp, int thread, Exploration& result) const;
+    void explore_open_landmarks(LandmarkNode* bp);
+    void get_exploration(LandmarkNode* bp, vector<vector<int> >& lvl_var,
+                         vector<pair<int, int> >& forward_orders);
  
-    void find_forward_orders(const vector<vector<int> >& lvl_var, LandmarkNode* lmp);
+    void find_forward_orders(const vector<vector<int> >& lvl_var,
+                             const LandmarkNode* lmp,
+                             vector<pair<int, int> >& result) const;
     void add_lm_forward_orders();
 
     void get_greedy_preconditions_for_lm(const LandmarkNode *lmp, const Operator& o, 
@@ -45,9 +64,10 @@ class LandmarksGraphNew : public LandmarksGraph {
         vector<vector<int> >& lvl_var,
         LandmarkNode* bp);
     void compute_predecessor_information(
-	LandmarkNode* bp,
+	const LandmarkNode* bp,
 	vector<vector<int> >& lvl_var,
-	vector<hash_map<pair<int, int>, int, hash_int_pair> >& lvl_op);
+	vector<hash_map<pair<int, int>, int, hash_int_pair> >& lvl_op,
+	int thread = 0) const;
     int min_cost_for_landmark(LandmarkNode* bp, vector<vector<int> >& lvl_var);
     void generate_landmarks();
     void found_lm_and_order(const pair<int, int> a, LandmarkNode& b, 
@@ -55,7 +75,8 @@ class LandmarksGraphNew : public LandmarksGraph {
     void found_disj_lm_and_order(const set<pair<int, int> >a, LandmarkNode& b, 
 				 edge_type t);
     void approximate_lookahead_orders(const vector<vector<int> >& lvl_var, 
-				      LandmarkNode* lmp);
+				      LandmarkNode* lmp,
+				      const vector<pair<int, int> >& forward_orders);
     static bool domain_connectivity(const pair<int, int>& landmark, const hash_set<int>& exclude);
 
 public:
@@ -24,6 +24,7 @@
 #define LANDMARKS_TYPES_H
 
 #include <utility>
+#include <vector>
 #include <ext/hash_set>
 #include <tr1/functional>
 
@@ -46,4 +47,41 @@ public:
 
 
 typedef __gnu_cxx::hash_set<std::pair<int, int>, hash_int_pair> lm_set;
+
+// Set of landmarks indexed by the dense ids assigned by
+// LandmarksGraph::compile(), stored as one bit per landmark
+class LandmarkBitset {
+    std::vector<unsigned int> words;
+public:
+    enum {WORD_BITS = 32};
+
+    static int num_words(int num_landmarks) {
+        return (num_landmarks + WORD_BITS - 1) / WORD_BITS;
+    }
+
+    void reset(int num_landmarks) {
+        words.assign(num_words(num_landmarks), 0);
+    }
+    bool test(int id) const {
+        return (words[id / WORD_BITS] >> (id % WORD_BITS)) & 1;
+    }
+    void set(int id) {
+        words[id / WORD_BITS] |= 1U << (id % WORD_BITS);
+    }
+    int count() const {
+        int result = 0;
+        for(int i = 0; i < words.size(); i++)
+            result += __builtin_popcount(words[i]);
+        return result;
+    }
+    // true if every landmark of the given mask is in the set
+    bool contains_all(const unsigned int *mask) const {
+        for(int i = 0; i < words.size(); i++)
+            if(mask[i] & ~words[i])
+                return false;
+        return true;
+    }
+    int get_num_words() const {return words.size();}
+    unsigned int get_word(int i) const {return words[i];}
+};
 #endif
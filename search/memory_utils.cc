@@ -6,10 +6,39 @@
 #else
 #endif
 
+#include <cstdlib>
 #include <iostream>
 #include <fstream>
+#include <new>
 #include <string>
 
+// allocations of the thread, counted by the replaced operator new
+static __thread unsigned int thread_allocations = 0;
+
+unsigned int get_thread_allocations() {
+    return thread_allocations;
+}
+
+void *operator new(std::size_t size) throw(std::bad_alloc) {
+    thread_allocations++;
+    void *p = std::malloc(size == 0 ? 1 : size);
+    if(p == 0)
+        throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](std::size_t size) throw(std::bad_alloc) {
+    return operator new(size);
+}
+
+void operator delete(void *p) throw() {
+    std::free(p);
+}
+
+void operator delete[](void *p) throw() {
+    operator delete(p);
+}
+
 void process_mem_usage(double &vm_usage, double &resident_set)
 {
 #ifdef __APPLE__
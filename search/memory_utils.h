@@ -11,3 +11,9 @@
  * On failure, returns 0.0, 0.0
  */
 void process_mem_usage(double &vm_usage, double &resident_set);
+
+/* returns the number of times the calling thread has allocated memory with
+ * new so far. Comparing it before and after a piece of code tells whether
+ * that code allocates.
+ */
+unsigned int get_thread_allocations();
@@ -1,4 +1,5 @@
 #include "mrw.h"
+#include "axioms.h"
 #include "globals.h"
 #include "walker.h"
 #include "successor_generator.h"
@@ -10,55 +11,57 @@
 #include <cmath>
 #include "plan_booster.h"
 
-vector<Node> Node::get_node_vector(vector <const Operator *> &path,
-		Heuristic *h, AxiomEvaluator *ae) {
-
-    vector<Node> node_path;
-
-    State s(*g_initial_state);
-    int cost = 0;
-
-    Node first_node(s, 0, 1, 0);
-    node_path.push_back(first_node);
-
-    // get heuristic of initiail state
-    h->set_recompute_heuristic(s);
-	h->evaluate(s);
-	assert(!h->is_dead_end());
-	float init_value = (float) h->get_heuristic();
-    // if initial state is given heuristic value of 0
-    // make it 1 for dividing reasons
-    if(init_value == 0)
-        init_value =  1.0;
-
-    for(int i = 0; i < path.size(); i++) {
-        assert(path[i]->is_applicable(s));
-        State next_state(s, *path[i], ae);
-
-		cost += path[i]->get_true_cost();
-
-        // get heuristic value for h_ratio
-        h->set_recompute_heuristic(next_state);
-		h->evaluate(next_state);
-		assert(!h->is_dead_end());
-		float h_ratio = ((float) h->get_heuristic())/init_value;
+WalkSlot::WalkSlot(Walker *w, AxiomEvaluator *a) : walker(w), axiom_eval(a),
+		start(*g_initial_state), start_index(-1), length(0), cost_bound(-1) {
+}
 
-        Node current_node(next_state, path[i], h_ratio, cost);
-        node_path.push_back(current_node);
+void WalkSlot::run_walk(MRW_Parameters &params) {
+	walker->random_walk(start, length, params, cost_bound, false);
+	walker->take_info(info);
+}
 
-        s = next_state;
-    }
-    return node_path;
+namespace {
+class RunWalksTask : public ParallelTask {
+	vector<WalkSlot *> &slots;
+	MRW_Parameters &params;
+public:
+	RunWalksTask(vector<WalkSlot *> &s, MRW_Parameters &p) :
+		slots(s), params(p) {}
+	virtual void run(int item, int) {
+		slots[item]->run_walk(params);
+	}
+};
 }
 
-MRW::MRW(AxiomEvaluator *a, MTRand_int32 *r, string s) :
-		axiom_eval(a), rand_gen(r), name(s) {
-    
-    walker = new Walker(axiom_eval, rand_gen);
+MRW::MRW(AxiomEvaluator *a, int t, UCB *l, string s) :
+		started(false), cpu_time(0), step_start_time(0), walk_thread_pool(0),
+		learner(l), axiom_eval(a), thread(t), name(s) {
+    rand_gen = new RandomStream(g_seed, RandomStream::ENGINE_STREAM, thread);
+    pool_rand_gen = new RandomStream(g_seed, RandomStream::POOL_STREAM,
+            thread);
+    slot_rand_gens.push_back(new RandomStream(g_seed,
+            RandomStream::WALKER_STREAM, thread, 0));
+
+    walker = new Walker(axiom_eval, slot_rand_gens[0]);
+    walk_slots.push_back(new WalkSlot(walker, axiom_eval));
 }
 
 MRW::~MRW() {
+    delete walk_thread_pool;
+    for(int i = 1; i < walk_slots.size(); i++) {
+        delete walk_slots[i]->walker;
+        for(int j = 0; j < walk_slots[i]->heuristics.size(); j++)
+            delete walk_slots[i]->heuristics[j];
+        delete walk_slots[i]->axiom_eval;
+        delete walk_slots[i];
+    }
+    for(int i = 0; i < slot_rand_gens.size(); i++)
+        delete slot_rand_gens[i];
+    delete walk_slots[0];
     delete walker;
+    delete learner;
+    delete rand_gen;
+    delete pool_rand_gen;
 }
 
 void MRW::compute_biases(){
@@ -71,7 +74,7 @@ void MRW::compute_biases(){
             walk_value = 1; 
         }
 	for (int i = 0; i < current_trajectory.size(); ++i) {
-		float h_ratio = current_trajectory[i].get_h_ratio();
+		float h_ratio = current_trajectory.get_h_ratio(i);
 		bias[i] = exp((walk_value - h_ratio)/(params.h_path_temp));
 		//cout << i << ": " << bias[i] << endl;
 		sum_biases += bias[i];
@@ -84,7 +87,7 @@ int MRW::select_initial_point(){
 		return (current_trajectory.size() - 1);
 
 	if(params.step_type == params.PATH){
-		int index = rand_gen->get_32bit_int() % current_trajectory.size();
+		int index = rand_gen->get_bounded(current_trajectory.size());
 		return index;
 	}
 
@@ -119,16 +122,29 @@ int MRW::select_initial_point(){
 
 // get latest solution cost and calculate bound
 int MRW::get_solution_bound(){
+	// the bound is lowered to the plans of all threads, and only needs to
+	// be looked at when one of them found a new one
+	int epoch = g_solution_bound.get_epoch();
+	if(epoch != bound_epoch) {
+		bound_epoch = epoch;
+		int cost = g_solution_bound.get_cost();
+		if(cost != -1 && (local_bound == -1 || cost - 1 < local_bound))
+			local_bound = cost - 1;
+	}
 	if(local_bound == -1)
 		return -1;
 	return local_bound;
-	/*if(g_best_sol_cost == -1)
+	/*if(g_solution_bound.get_cost() == -1)
 			return -1;
-	return int(params.bounding_factor * g_best_sol_cost);*/
+	return int(params.bounding_factor * g_solution_bound.get_cost());*/
 }
 
 int MRW::step() {
 
+	// some other thread has found a solution and can stop
+	if(g_solution_bound.is_cancelled())
+		return SOLVED;
+
 	if(g_mrw_shared->mrw_time_limit > 0 &&
 			timer() > g_mrw_shared->mrw_time_limit){
 		cout << name << "MRW Time Limit Reached" << endl;
@@ -143,7 +159,7 @@ int MRW::step() {
 		compute_biases();
 
 	current_min = A_LOT;
-	Path best_path;
+	best_path.clear();
 	int min_cost = INT_MAX;
 	int arg_min = -1;
 	
@@ -166,101 +182,138 @@ int MRW::step() {
 	//cout << " total_min: " << total_min << endl;
 	//cout << endl;
 
-    walker->prepare_for_walks(params, heuristic);
+    // the trajectory may have changed since the last step
+    for(int k = 0; k < walk_slots.size(); k++) {
+        WalkSlot &slot = *walk_slots[k];
+        slot.walker->prepare_for_walks(params, slot.heuristics[params.heur_index]);
+        slot.start_index = -1;
+    }
 
-	int i;
-	for (i = 0; i < params.num_walk; ++i) {
+    // The walks of a batch are selected and started with the values that
+    // the first of them would have been run with on its own. Their results
+    // are then processed in order and those after an early exit are
+    // discarded. With one walk slot this is the sequential algorithm, with
+    // more it deviates from it:
+    // - each slot has its own walker, so the action values of MDA and MHA
+    //   walks of a slot only come from its own walks (unless the action
+    //   values are shared), and the walks of a batch do not see each other;
+    // - discarded walks are not rolled back, they have already updated the
+    //   action values of their slot and the store of learned dead ends;
+    // - a longer walk length from deepening only applies to the next batch.
+	int i = 0;
+	bool stop = false;
+	while (i < params.num_walk && !stop) {
 		
         // performs walk length changes    
 		length_walk = av_length_walk;
 
-		//cout << random() << endl;
-		int index = select_initial_point();
-		//cout << random() << endl;
-
-		int current_cost = current_trajectory[index].get_cost();
-		
-        int walk_cost_bound = -1;
-
-        // TODO Probably could move this
-        // some other thread has found a solution and can stop
-        if(!g_iterative && g_best_sol_cost != -1)
-        	return SOLVED;
-
-        int bound = get_solution_bound();
-        if(bound != -1) {
-            walk_cost_bound =  bound - current_cost;
-        }
-
-		//if(index != 0)
-		//	cout << "Initial point: " << index << " current cost: " << current_cost  << " cost bound: " << walk_cost_bound << endl;
-		/*if( i == 45)
-			walker->random_walk(current_trajectory[index].get_state(), int(length_walk), params, walk_cost_bound, true);
-		else*/
-			walker->random_walk(current_trajectory[index].get_state(), int(length_walk), params, walk_cost_bound, false);
+		int batch_size = min((int) walk_slots.size(), params.num_walk - i);
+		for (int k = 0; k < batch_size; ++k) {
+			WalkSlot &slot = *walk_slots[k];
 
-		evaluated_states ++;
-		WalkInfo info = walker->get_info();
+			//cout << random() << endl;
+			int index = select_initial_point();
+			//cout << random() << endl;
 
-		assert(length_walk != 0 );
-		// It happens that the length of walk is smaller than what was expected (it might hit a dead-end)
-		int real_length_walk = int(length_walk) + info.length_offset;
-	
-		avg_branching += info.branching/(real_length_walk);
-
-        // have hit a dead-end
-		if (info.value == A_LOT) {
-			//cout << "info.cost: " << info.cost << endl;
-			num_dead_ends ++;
-			continue;
+			int current_cost = current_trajectory.get_cost(index);
+		
+	        slot.cost_bound = -1;
+
+	        // TODO Probably could move this
+	        // some other thread has found a solution and can stop
+	        if(g_solution_bound.is_cancelled())
+	        	return SOLVED;
+
+	        int bound = get_solution_bound();
+	        if(bound != -1) {
+	            slot.cost_bound =  bound - current_cost;
+	        }
+
+			//if(index != 0)
+			//	cout << "Initial point: " << index << " current cost: " << current_cost  << " cost bound: " << slot.cost_bound << endl;
+			// The walker recognises a start state by its address, so it is
+			// told when the start of the slot is rebuilt for another node.
+			if(index != slot.start_index) {
+				slot.start = current_trajectory.get_state(index, axiom_eval);
+				slot.start_index = index;
+				slot.walker->forget_walk_start();
+			}
+			slot.length = int(length_walk);
 		}
+		run_walks(batch_size);
 
-		/*if(walk_cost_bound != -1){
-			assert(compute_cost(info.path) <= walk_cost_bound);
-		}*/
+		for (int k = 0; k < batch_size && !stop; ++k) {
+			WalkSlot &slot = *walk_slots[k];
+			int index = slot.start_index;
+			int current_cost = current_trajectory.get_cost(index);
+			WalkInfo &info = slot.info;
 
-		if (info.goal_visited) {
-			current_min = 0;
-			total_min = 0;
-			update_trajectory(index, info.path);
+			evaluated_states ++;
+			episode_evaluations++;
 
-			State temp_state = current_trajectory.back().get_state();
-			assert(check_goal(&temp_state));
-			Path current_path;
-			get_current_path(current_path);
-			int cost = save_plan(current_path, g_output_filename, name, false);
-			local_bound = cost - 1;
-			postprocess(current_path);
-
-			checkpoint_path = current_trajectory;
-			if(!g_iterative)
-				return SOLVED;
+			assert(length_walk != 0 );
+			// It happens that the length of walk is smaller than what was expected (it might hit a dead-end)
+			int real_length_walk = int(length_walk) + info.length_offset;
+	
+			avg_branching += info.branching/(real_length_walk);
+
+	        // have hit a dead-end
+			if (info.value == A_LOT) {
+				//cout << "info.cost: " << info.cost << endl;
+				num_dead_ends ++;
+				i++;
+				continue;
+			}
 
-			restart();
-			return IN_PROGRESS;
-		}
+			/*if(slot.cost_bound != -1){
+				assert(compute_cost(info.path) <= slot.cost_bound);
+			}*/
+
+			if (info.goal_visited) {
+				current_min = 0;
+				total_min = 0;
+				update_trajectory(index, info.path);
+
+				State temp_state = current_trajectory.get_state(
+						current_trajectory.size() - 1, axiom_eval);
+				assert(check_goal(&temp_state));
+				Path current_path;
+				get_current_path(current_path);
+				int cost = save_plan(current_path, g_output_filename, name, false);
+				local_bound = cost - 1;
+				postprocess(current_path);
+
+				checkpoint_path = current_trajectory;
+				if(!g_iterative)
+					return SOLVED;
+
+				restart();
+				return IN_PROGRESS;
+			}
 
-		int pre_value = current_min;
-		update_current_min(i, index, info, best_path, (info.cost + current_cost), min_cost, arg_min);
-		progress = total_min - info.value;
-		if (progress > acceptable_progress && !first_step){
-			//cout << "Acceptable progress is achieved." << endl;
-			break;
-		}
+			int pre_value = current_min;
+			update_current_min(i, index, info, best_path, (info.cost + current_cost), min_cost, arg_min);
+			progress = total_min - info.value;
+			if (progress > acceptable_progress && !first_step){
+				//cout << "Acceptable progress is achieved." << endl;
+				stop = true;
+				break;
+			}
 		
-		// Increase the length of the walk if current_min has not be 
-		// decreased in n last walks.
-        if (params.deepening) {
-			int n = int(params.num_walk * params.extending_period);
-			if (current_min < pre_value)
-				last_effective_walk = i;
-			else if (i - last_effective_walk > n) {
-				av_length_walk = av_length_walk * params.extending_rate;
-				av_length_jump = av_length_jump * params.extending_rate;
-                last_effective_walk = i;
+			// Increase the length of the walk if current_min has not be 
+			// decreased in n last walks.
+	        if (params.deepening) {
+				int n = int(params.num_walk * params.extending_period);
+				if (current_min < pre_value)
+					last_effective_walk = i;
+				else if (i - last_effective_walk > n) {
+					av_length_walk = av_length_walk * params.extending_rate;
+					av_length_jump = av_length_jump * params.extending_rate;
+	                last_effective_walk = i;
+				}
 			}
+			i++;
 		}
-
 	}
 
 	update_acceptable_progress();
@@ -303,12 +356,7 @@ void MRW::postprocess(Path& current_path){
 }
 
 void MRW::get_current_path(Path& output){
-	vector<Node>::iterator curr, end = current_trajectory.end();
-	for(curr = current_trajectory.begin(); curr != end; ++curr) {
-		const Operator * op = curr->get_op();
-		if(op != 0)
-			output.push_back(op);
-	}
+	current_trajectory.get_path(output);
 }
 
 void MRW::update_trajectory(int index, Path& path) {
@@ -316,14 +364,13 @@ void MRW::update_trajectory(int index, Path& path) {
 		return;
 
 	assert(index >= 0 && index < current_trajectory.size());
-	current_trajectory.erase(current_trajectory.begin() + index + 1, current_trajectory.end());
-	assert(current_trajectory.size() == index + 1);
+	current_trajectory.truncate(index + 1);
 
     // params for conservative steps
 	int min = total_min;
 	int arg_min = current_trajectory.size() - 1;
-	State state = current_trajectory.back().get_state();
-	int cost = current_trajectory.back().get_cost();
+	State state = current_trajectory.get_state(index, axiom_eval);
+	int cost = current_trajectory.get_cost(index);
 	Path::iterator curr, end = path.end();
 	for(curr = path.begin(); curr != end; ++curr) {
 		const Operator* op = *curr;
@@ -344,18 +391,18 @@ void MRW::update_trajectory(int index, Path& path) {
 			else if (total_min != 0){
 				h_ratio = 1;
 			}
-			current_trajectory.push_back(Node(state, op, h_ratio, cost));
+			current_trajectory.push_back(state, op, h_ratio, cost);
 			if(h < min){
 				arg_min = current_trajectory.size() - 1;
 				min = h;
 			}
 		}else{
-			current_trajectory.push_back(Node(state, op, -1, cost));
+			current_trajectory.push_back(state, op, -1, cost);
 		}
 	}
 	if(params.conservative_steps){
 		assert(min < total_min);
-		current_trajectory.erase(current_trajectory.begin() + arg_min + 1, current_trajectory.end());
+		current_trajectory.truncate(arg_min + 1);
 		current_min = min;
 	}
 }
@@ -387,6 +434,91 @@ void MRW::update_acceptable_progress() {
 
 void MRW::add_heuristic(Heuristic * h) {
     heuristics.push_back(h);
+    walk_slots[0]->heuristics.push_back(h);
+    if(g_heuristic_cache != NULL && h->is_worth_caching())
+        h->set_cache(g_heuristic_cache);
+}
+
+void MRW::add_walk_slot(AxiomEvaluator *a,
+		const vector<Heuristic *> &slot_heuristics) {
+    RandomStream *r = new RandomStream(g_seed, RandomStream::WALKER_STREAM,
+            thread, walk_slots.size());
+    WalkSlot *slot = new WalkSlot(new Walker(a, r), a);
+    slot->heuristics = slot_heuristics;
+    for(int i = 0; i < slot_heuristics.size(); i++) {
+        if(g_heuristic_cache != NULL && slot_heuristics[i]->is_worth_caching())
+            slot_heuristics[i]->set_cache(g_heuristic_cache);
+    }
+    walk_slots.push_back(slot);
+    slot_rand_gens.push_back(r);
+}
+
+void MRW::run_walks(int batch_size) {
+    RunWalksTask task(walk_slots, params);
+    if(walk_thread_pool != 0 && batch_size > 1) {
+        walk_thread_pool->run(task, batch_size);
+    } else {
+        for(int k = 0; k < batch_size; k++)
+            task.run(k, 0);
+    }
+}
+
+int MRW::search_step() {
+	step_start_time = get_thread_time();
+	if(!started) {
+		initialize();
+		started = true;
+	}
+	int status = step();
+	cpu_time += get_thread_time() - step_start_time;
+	return status;
+}
+
+double MRW::get_cpu_time() const {
+	return cpu_time + get_thread_time() - step_start_time;
+}
+
+void MRW::statistics() const {
+    cout << name << "Evaluated " << evaluated_states << " walk endpoint(s)"
+        << endl;
+    int computed = 0, duplicates = 0;
+    for(int i = 0; i < walk_slots.size(); i++) {
+        computed += walk_slots[i]->walker->num_evaluated;
+        duplicates += walk_slots[i]->walker->get_num_duplicates();
+    }
+    if(computed + duplicates > 0)
+        cout << name << duplicates << " of " << computed + duplicates
+            << " walk endpoint(s) repeated one of the same step ("
+            << 100.0 * duplicates / (computed + duplicates) << "%)" << endl;
+    int walks = 0, allocating = 0, allocations = 0;
+    for(int i = 0; i < walk_slots.size(); i++) {
+        walks += walk_slots[i]->walker->num_walks;
+        allocating += walk_slots[i]->walker->num_allocating_walks;
+        allocations += walk_slots[i]->walker->walk_allocations;
+    }
+    if(walks > 0)
+        cout << name << allocating << " of " << walks
+            << " walk(s) allocated memory, " << allocations
+            << " allocation(s) in all" << endl;
+    // the other walk slots have copies of the heuristics
+    for(int i = 0; i < heuristics.size(); i++) {
+        int hits = 0, misses = 0;
+        for(int k = 1; k < walk_slots.size(); k++) {
+            hits += walk_slots[k]->heuristics[i]->get_cache_hits();
+            misses += walk_slots[k]->heuristics[i]->get_cache_misses();
+        }
+        heuristics[i]->print_cache_statistics(name, hits, misses);
+    }
+    if(g_dead_end_store != NULL) {
+        int learned = 0, pruned = 0;
+        for(int i = 0; i < walk_slots.size(); i++) {
+            learned += walk_slots[i]->walker->get_num_dead_ends_learned();
+            pruned += walk_slots[i]->walker->get_num_dead_end_pruned();
+        }
+        cout << name << "Learned " << learned
+            << " dead end(s), pruned " << pruned
+            << " walk step(s)" << endl;
+    }
 }
 
 void MRW::initialize() {
@@ -400,6 +532,12 @@ void MRW::initialize() {
 	}*/
 	cout << name << "MRW ..." << endl;
 
+	if(walk_slots.size() > 1 && walk_thread_pool == 0) {
+		cout << name << "Running walks on " << walk_slots.size()
+			<< " threads" << endl;
+		walk_thread_pool = new ThreadPool(walk_slots.size());
+	}
+
 	num_jumps = 0;
 	config_id = -1;
 	pre_value = INT_MAX;
@@ -430,37 +568,35 @@ void MRW::initialize() {
     initial_value = curr_heur_init_value;
     total_min = curr_heur_init_value;
     
-	current_trajectory.push_back(Node(*g_initial_state, 0, 1, 0));
+	current_trajectory.reset(*g_initial_state);
 	checkpoint_path = current_trajectory;
 	
     // prepare pool for smart restarts
-	if(g_mrw_shared->restart_type == Shared_MRW_Parameters::S_RESTART){
-		pthread_mutex_lock(&mutex_w_pool);
-		current_walk = g_walk_pool->get_random_walk();
-		pthread_mutex_unlock(&mutex_w_pool);
-	}
+	if(g_mrw_shared->restart_type == Shared_MRW_Parameters::S_RESTART)
+		pool_reader = g_walk_pool->register_reader();
 	first_step = true;
     evaluated_states = 0;
     local_bound = -1;
+    bound_epoch = 0;
 }
 
 void MRW::set_params(){
 
-	// only one thread has access to the p_learner at any one time
-	pthread_mutex_lock(&mutex_p_learner);
-
     //update if have run at least once before
+	double now = get_cpu_time();
 	if(config_id != -1)
-		p_learner->update_value(config_id, total_min, curr_heur_init_value,
-				name);
+		learner->update_value(config_id, total_min, curr_heur_init_value,
+				now - episode_start_time, episode_evaluations, name);
+	episode_start_time = now;
+	episode_evaluations = 0;
 
     // get next config to run
-	config_id = p_learner->get_config();
+	config_id = learner->get_config();
 
 	assert(config_id >= 0 && config_id < g_params_list.size());
 
 	params = (*g_params_list[config_id]);
-	pthread_mutex_unlock(&mutex_p_learner);
+	learner->adjust_params(config_id, params);
 
 	cout << name << "Selecting config " << config_id << endl;
 
@@ -487,10 +623,11 @@ void MRW::update_current_min(int walk_number, int index, WalkInfo& info, Path& m
 		     cout << name << "h: " << current_min << " walk#: " <<
 				 walk_number << endl;
 
-		min_path = info.path;
+		// the slot reuses the buffer of the old best path
+		min_path.swap(info.path);
 		min_cost = cost;
 	} else if(params.tie_breaking && info.value == current_min && (cost < min_cost)){
-		min_path = info.path;
+		min_path.swap(info.path);
 		arg_min = index;
 		min_cost = cost;
 	    //cout << "h: " << current_min << " cost: " << cost << endl;
@@ -499,8 +636,7 @@ void MRW::update_current_min(int walk_number, int index, WalkInfo& info, Path& m
 
 void MRW::basic_restart(){
 	cout << name  << "basic restart" << endl;
-	current_trajectory.clear();
-	current_trajectory.push_back(Node(*g_initial_state, 0, 1, 0));
+	current_trajectory.reset(*g_initial_state);
 	checkpoint_path = current_trajectory;
 }
 
@@ -511,6 +647,8 @@ void MRW::s_restart(){
     if(heuristics.size() > 0) {
         while(checkpoint_path.size() > 1) {
             bool is_dead_end = false;
+            State last_state = checkpoint_path.get_state(
+                    checkpoint_path.size() - 1, axiom_eval);
 
             // check all other heuristics
             for(int i = 0; i < heuristics.size(); i++) {
@@ -518,8 +656,8 @@ void MRW::s_restart(){
                 //can ignore the current heuristic
                 if(i == params.heur_index)
                     continue;
-		        heuristics[i]->set_recompute_heuristic(checkpoint_path.back().get_state());
-		        heuristics[i]->evaluate(checkpoint_path.back().get_state());
+		        heuristics[i]->set_recompute_heuristic(last_state);
+		        heuristics[i]->evaluate(last_state);
 		        
                 // if it actually is a dead end
                 if(heuristics[i]->is_dead_end()) {
@@ -542,12 +680,8 @@ void MRW::s_restart(){
         walk_value = 1; 
     }
 
-    // grab walk pool lock
-    pthread_mutex_lock(&mutex_w_pool);
-
-    g_walk_pool->add_walk(checkpoint_path, checkpoint_path.size(),
-    		walk_value, name);
-    current_walk = g_walk_pool->get_random_walk();
+    g_walk_pool->add_walk(pool_reader, checkpoint_path,
+    		checkpoint_path.size(), walk_value, name);
 
     if(g_mrw_shared->restart_type == Shared_MRW_Parameters::S_RESTART &&
     		params.bounding != params.NONE){
@@ -559,11 +693,8 @@ void MRW::s_restart(){
         }
     }
 
-    // release walk pool lock
-    pthread_mutex_unlock(&mutex_w_pool);
-
-	current_trajectory.clear();
-	current_walk->get_random_subseq(current_trajectory, rand_gen, name);
+	g_walk_pool->get_random_subseq(pool_reader, current_trajectory,
+			pool_rand_gen, name);
 	checkpoint_path = current_trajectory;
 }
 
@@ -583,8 +714,10 @@ void MRW::restart(){
 	if(g_mrw_shared->restart_type == Shared_MRW_Parameters::BASIC)
 		initial_value = curr_heur_init_value;
     else {
-		    heuristic->set_recompute_heuristic(current_trajectory.back().get_state());
-		    heuristic->evaluate(current_trajectory.back().get_state());
+		    State state = current_trajectory.get_state(
+		            current_trajectory.size() - 1, axiom_eval);
+		    heuristic->set_recompute_heuristic(state);
+		    heuristic->evaluate(state);
 		    assert(!heuristic->is_dead_end());
 		    initial_value = heuristic->get_heuristic();
     }
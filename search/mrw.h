@@ -11,8 +11,10 @@
 #include "mrw_parameters.h"
 #include "parameter_learner.h"
 #include "plan_booster.h"
-#include "mtrand.h"
+#include "random_stream.h"
 #include "timer.h"
+#include "trajectory.h"
+#include "thread_pool.h"
 
 typedef vector<const Operator*> Path;
 
@@ -22,21 +24,26 @@ class Walk;
 class WalkPool;
 class MRW;
 
-class Node {
-	State state;
-	const Operator* op;
-	float h_ratio;
-	int cost;
-public:
-	Node(const State& _state, const Operator* _op, float _h_ratio, int _c) :
-		state(_state), op(_op), h_ratio(_h_ratio), cost(_c){}
-	State get_state(){return state;}
-	float get_h_ratio(){return h_ratio;}
-	const Operator* get_op() {return op;}
-	int get_cost(){return cost;}
-
-	static vector<Node> get_node_vector(vector <const Operator *> &path,
-			Heuristic *h, AxiomEvaluator *ae);
+/**
+ * What one of the threads of an MRW search needs to run walks: a walker, its
+ * own instances of the heuristics, and the walk it runs next and its result.
+**/
+struct WalkSlot {
+	Walker *walker;
+	AxiomEvaluator *axiom_eval;
+	vector<Heuristic *> heuristics;
+
+	// state of the trajectory node that walks start from, rebuilt when
+	// another node is selected
+	State start;
+	int start_index;
+
+	int length;
+	int cost_bound;
+	WalkInfo info;
+
+	WalkSlot(Walker *w, AxiomEvaluator *a);
+	void run_walk(MRW_Parameters &params);
 };
 
 class MRW : public SearchEngine {
@@ -44,9 +51,19 @@ public:
 private:
 	int initial_value;
 	int evaluated_states;
+	// cost of the episode of the current config so far, for the learner
+	double episode_start_time;
+	int episode_evaluations;
+	// The steps of the engine may run on different threads, so its CPU time
+	// is summed up over the steps.
+	bool started;
+	double cpu_time;
+	double step_start_time;
 	int num_jumps;
 	int pre_value;
 	int local_bound;
+	// epoch of g_solution_bound that local_bound was last lowered to
+	int bound_epoch;
 	float avg_branching;
 	float acceptable_progress;
 	float failure_percentage;
@@ -56,12 +73,15 @@ private:
 
 	//State current_state;
 	LandmarksCountHeuristic* walking_heuristic;
-	vector<Node> current_trajectory;
+	Trajectory current_trajectory;
+	// best walk of the current step, kept between steps for its memory
+	Path best_path;
 	vector<float> bias;
 
 	double sum_biases;
 	int max_num_plans;
-	Walk* current_walk;
+	// id of this thread in g_walk_pool
+	int pool_reader;
 	
     Walker* walker;
 
@@ -70,7 +90,19 @@ private:
 	MRW_Parameters params;
 	int num_plans;
 	bool first_step;
-	vector<Node> checkpoint_path;
+	Trajectory checkpoint_path;
+
+	// The walks of a step are run in batches, one walk per slot, on
+	// walk_thread_pool if there is more than one slot. The first slot holds
+	// walker, axiom_eval and the heuristics of the engine.
+	vector<WalkSlot *> walk_slots;
+	ThreadPool *walk_thread_pool;
+	// the walkers and heuristics of the other slots, and the generators of
+	// all slots
+	vector<RandomStream *> slot_rand_gens;
+
+	// the parameter learner of this thread
+	UCB *learner;
 
     // probably can change these vectors to arrays if are careful
     // list of heuristics used by the configurations
@@ -82,7 +114,10 @@ private:
     vector<int> init_heur_values;
 
     AxiomEvaluator *axiom_eval;
-    MTRand_int32 *rand_gen;
+    // the index of this thread, which its random streams are derived from
+    int thread;
+    RandomStream *rand_gen;
+    RandomStream *pool_rand_gen;
 
     string name;
     Timer timer;
@@ -108,6 +143,9 @@ private:
 	void compute_biases();
 	void postprocess(Path& path);
 	int get_solution_bound();
+	void run_walks(int batch_size);
+	// CPU seconds that the engine has used so far
+	double get_cpu_time() const;
 
 protected:
 	virtual int step();
@@ -116,14 +154,21 @@ protected:
 public:
 	enum{A_LOT=10000000};
 	virtual void add_heuristic(Heuristic *heuristic);
-
-	MRW(AxiomEvaluator *a, MTRand_int32 *r, string s);
+	// Adds a slot for running walks in parallel. The heuristics must be
+	// created in the same order as those added with add_heuristic.
+	void add_walk_slot(AxiomEvaluator *a,
+			const vector<Heuristic *> &slot_heuristics);
+	virtual void statistics() const;
+	// runs one step, after initializing the search if this is the first
+	int search_step();
+
+	MRW(AxiomEvaluator *a, int t, UCB *l, string s);
 	//MRW(int n);
 	virtual ~MRW();
 };
 
 /** Returns random number normally distributed with mean 1 and stdev 1
  */
-double gaussian_rand(MTRand_int32 *rand_gen);
+double gaussian_rand(RandomStream *rand_gen);
 
 #endif /*MRW_H_*/
@@ -150,6 +150,10 @@ void MRW_Parameters::print_values() {
     	cout << "Blind" << endl;
     else if(heur == MRW_Parameters::GOAL_COUNT)
     	cout << "Goal Count" << endl;
+    else if(heur == MRW_Parameters::PDB)
+    	cout << "PDB" << endl;
+    else if(heur == MRW_Parameters::CG)
+    	cout << "CG" << endl;
 
     cout << "\t\tStep Type: ";
     if(step_type == MRW_Parameters::STATE)
@@ -463,6 +467,10 @@ bool MRW_Parameters::get_mrw_heur_type(std::string str_heur) {
         heur = MRW_Parameters::BLIND;
     else if(str_heur.compare("GOAL_COUNT") == 0)
     	heur = MRW_Parameters::GOAL_COUNT;
+    else if(str_heur.compare("PDB") == 0)
+    	heur = MRW_Parameters::PDB;
+    else if(str_heur.compare("CG") == 0)
+    	heur = MRW_Parameters::CG;
     else {
         cerr << "Input of " << str_heur << " is an invalid MRW heuristic" << 
             endl;
@@ -479,7 +487,7 @@ void MRW_Parameters::print_help_info() {
         endl;
     cerr << "\t-nodeep : changes deepening to false" << endl;
     cerr << "\t-walk_type PURE|MDA|MHA : changes walk type. PURE by default." << 
-        "\n\t\tNote, MHA can't be used with GOAL_COUNT or BLIND heuristic" << endl;
+        "\n\t\tNote, MHA can't be used with GOAL_COUNT, BLIND or PDB heuristic" << endl;
     cerr << "\t-step_type STAT|PATH|H_PATH : selects step type. STATE by " <<
         "default" << endl;
     cerr << "\t-bounding NONE|F|G: selects pruning style. NONE by default" 
@@ -512,7 +520,8 @@ bool MRW_Parameters::check_for_conflicts() {
 
 	if(walk_type == MRW_Parameters::MHA) {
 		if(heur == MRW_Parameters::GOAL_COUNT ||
-				heur == MRW_Parameters::BLIND) {
+				heur == MRW_Parameters::BLIND ||
+				heur == MRW_Parameters::PDB) {
 			cerr << "Can't use MHA with the given heuristic" << endl;
 			return false;
 		}
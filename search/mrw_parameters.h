@@ -34,7 +34,7 @@ protected:
 public:	
 	enum {PURE = 0, MDA = 1, MHA = 2}; 
     enum {FD_FF = 0, LM = 1, LAMA_FF = 2, LAMA_FF_S = 3, LAMA_FF_C = 4, 
-            BLIND = 5, GOAL_COUNT = 6};
+            BLIND = 5, GOAL_COUNT = 6, PDB = 7, CG = 8};
     enum {STATE = 0, PATH = 1, H_PATH = 2};
     enum {NONE = 0, G_PRUNING = 1, F_PRUNING = 2};
 
@@ -5,6 +5,8 @@
 #include "landmarks_graph.h"
 #include "string.h"
 #include "mrw.h"
+#include "mrw_scheduler.h"
+#include "action_values.h"
 
 #include "ff_heuristic.h"
 #include "fd_ff_heuristic.h"
@@ -13,72 +15,81 @@
 #include "blind_search_heuristic.h"
 #include "landmarks_count_heuristic.h"
 #include "goal_count_heuristic.h"
+#include "pdb_heuristic.h"
+#include "cg_heuristic.h"
 
 void fix_mrw_configs();
 void add_heuristics(MRW* engine, AxiomEvaluator *axiom_eval);
+void create_heuristics(vector<Heuristic *> &heuristics,
+		AxiomEvaluator *axiom_eval);
+
+namespace {
+class CreateEnginesTask : public ParallelTask {
+    vector<MRW *> &engines;
+    vector<UCB *> &learners;
+    bool unnamed;
+public:
+    CreateEnginesTask(vector<MRW *> &e, vector<UCB *> &l, bool u) :
+        engines(e), learners(l), unnamed(u) {}
+    virtual void run(int item, int) {
+        string name = unnamed ? "" : "$MRW" + int_to_string(item) + " - ";
+        engines[item] = create_engine(item, learners[item], name);
+    }
+};
+}
 
 void run_mrw_search(bool finish_mrw_before_exit) {
 
-    // initialize parameter learner
-    p_learner = new UCB(g_mrw_shared->ucb_const, g_mrw_shared->adjust_online,
-    		new MTRand_int32(get_current_seed(11)));
+    // initialize parameter learners, one per thread
+    g_ucb_stats = new UCBStats(g_params_list.size());
+    vector<UCB *> learners;
+    for(int i = 0; i < g_mrw_shared->num_threads; i++)
+        learners.push_back(create_learner(i));
 
-    // create pool for smart restarts
+    // create pool for smart restarts, with room for the engine that WA* may
+    // start once the others are done
 	if(g_mrw_shared->restart_type == Shared_MRW_Parameters::S_RESTART){
 	    g_walk_pool = new WalkPool(g_mrw_shared->pool_size, 
-                g_mrw_shared->act_level, new MTRand_int32(get_current_seed(29)));
+                g_mrw_shared->act_level, g_mrw_shared->num_threads + 1);
     }
 
-    fix_mrw_configs();
+    if(g_mrw_shared->shared_q_weight > 0)
+        g_action_values = new SharedActionValues(g_operators.size(),
+                g_mrw_shared->shared_q_weight);
 
-    int num_to_run = g_mrw_shared->num_threads;
-    if(finish_mrw_before_exit)
-    	num_to_run--;
-
-    pthread_t *mrw_threads = new pthread_t[num_to_run];
-    struct mrw_thread_data *thread_data = new mrw_thread_data[num_to_run];
-
-    for(int i = 0; i < num_to_run; i++) {
-    	thread_data[i].seed = get_current_seed(1984);
-    	thread_data[i].name = "$MRW" + int_to_string(i) + " - ";
+    fix_mrw_configs();
 
-    	int rc = pthread_create(&mrw_threads[i], NULL, run_mrw_thread,
-    			(void *)&thread_data[i]);
-    	if(rc) {
-    		cerr << "ERROR: Return code from pthreade_create is " << rc << endl;
-    	    exit(-1);
-    	}
+    // the engines are built by the preprocessing threads, which are idle by
+    // now
+    vector<MRW *> engines(g_mrw_shared->num_threads);
+    CreateEnginesTask task(engines, learners,
+            finish_mrw_before_exit && g_mrw_shared->num_threads == 1);
+    if(g_thread_pool != NULL) {
+        g_thread_pool->run(task, engines.size());
+    } else {
+        for(int i = 0; i < engines.size(); i++)
+            task.run(i, 0);
     }
 
-    if(finish_mrw_before_exit) {
-    	struct mrw_thread_data my_data;
-    	my_data.seed = get_current_seed(1984);
-
-    	if(num_to_run > 0)
-    		my_data.name = "$MRW" + int_to_string(num_to_run) + " - ";
-    	else
-    		my_data.name = "";
-
-    	//TODO Clean this up after competition deadline since just duplicating below
-    	AxiomEvaluator *axiom_eval = new AxiomEvaluator;
-    	MRW * engine = new MRW(axiom_eval, new MTRand_int32(my_data.seed),
-    			my_data.name);
-    	add_heuristics(engine, axiom_eval);
+    // the thread that runs WA* may join the workers later
+    int num_workers = g_mrw_shared->num_workers;
+    g_mrw_scheduler = new MRWScheduler(num_workers + 1);
+    for(int i = 0; i < engines.size(); i++)
+        g_mrw_scheduler->add_engine(engines[i]);
 
-    	engine->search();
+    if(finish_mrw_before_exit) {
+        g_mrw_scheduler->start_workers(num_workers - 1);
+        g_mrw_scheduler->work();
+    } else {
+        g_mrw_scheduler->start_workers(num_workers);
     }
 }
 
-void *run_mrw_thread(void *data){
-	struct mrw_thread_data *my_data = (struct mrw_thread_data *)data;
-
+MRW *create_engine(int thread, UCB *learner, const string &name) {
 	AxiomEvaluator *axiom_eval = new AxiomEvaluator;
-	MRW * engine = new MRW(axiom_eval, new MTRand_int32(my_data->seed),
-			my_data->name);
+	MRW *engine = new MRW(axiom_eval, thread, learner, name);
 	add_heuristics(engine, axiom_eval);
-
-	engine->search();
-	pthread_exit(NULL);
+	return engine;
 }
 
 void fix_mrw_configs() {
@@ -95,7 +106,29 @@ void fix_mrw_configs() {
     }  
 }
 
+UCB *create_learner(int thread) {
+    return new UCB(g_ucb_stats, g_mrw_shared->ucb_const,
+            g_mrw_shared->ucb_reward, g_mrw_shared->adjust_online,
+            new RandomStream(g_seed, RandomStream::LEARNER_STREAM, thread));
+}
+
 void add_heuristics(MRW* engine, AxiomEvaluator *axiom_eval){
+    vector<Heuristic *> heuristics;
+    create_heuristics(heuristics, axiom_eval);
+    for(int i = 0; i < heuristics.size(); i++)
+        engine->add_heuristic(heuristics[i]);
+
+    // every further walk thread gets its own walker and heuristics
+    for(int i = 1; i < g_mrw_shared->walk_threads; i++) {
+        AxiomEvaluator *slot_axiom_eval = new AxiomEvaluator;
+        vector<Heuristic *> slot_heuristics;
+        create_heuristics(slot_heuristics, slot_axiom_eval);
+        engine->add_walk_slot(slot_axiom_eval, slot_heuristics);
+    }
+}
+
+void create_heuristics(vector<Heuristic *> &heuristics,
+		AxiomEvaluator *axiom_eval){
 
         // heuristics to use in mrw
     bool mrw_fd_ff_heuristic = false;
@@ -105,6 +138,8 @@ void add_heuristics(MRW* engine, AxiomEvaluator *axiom_eval){
     bool mrw_lama_ff_c_heuristic = false;
     bool mrw_blind_heuristic = false;
     bool mrw_goal_count_heuristic = false;
+    bool mrw_pdb_heuristic = false;
+    bool mrw_cg_heuristic = false;
     
     bool need_lm_preferred = false;
 
@@ -129,6 +164,10 @@ void add_heuristics(MRW* engine, AxiomEvaluator *axiom_eval){
             mrw_blind_heuristic = true;
         } else if(g_params_list[i]->heur == MRW_Parameters::GOAL_COUNT) {
         	mrw_goal_count_heuristic = true;
+        } else if(g_params_list[i]->heur == MRW_Parameters::PDB) {
+        	mrw_pdb_heuristic = true;
+        } else if(g_params_list[i]->heur == MRW_Parameters::CG) {
+        	mrw_cg_heuristic = true;
         } else {
 
             cerr << "Should never be another kind of heuristic" << endl;
@@ -144,6 +183,8 @@ void add_heuristics(MRW* engine, AxiomEvaluator *axiom_eval){
     int lama_ff_c_index = -1;
     int blind_index = -1;
     int goal_count_index = -1;
+    int pdb_index = -1;
+    int cg_index = -1;
 
     int h_index = 0;
 
@@ -175,6 +216,14 @@ void add_heuristics(MRW* engine, AxiomEvaluator *axiom_eval){
     	goal_count_index = h_index;
     	h_index++;
     }
+    if(mrw_pdb_heuristic) {
+    	pdb_index = h_index;
+    	h_index++;
+    }
+    if(mrw_cg_heuristic) {
+    	cg_index = h_index;
+    	h_index++;
+    }
 
     // record index of heuristic in mrw
     for(int i = 0; i < g_params_list.size(); i++) {
@@ -192,30 +241,40 @@ void add_heuristics(MRW* engine, AxiomEvaluator *axiom_eval){
             g_params_list[i]->heur_index = blind_index;
         else if (g_params_list[i]->heur == MRW_Parameters::GOAL_COUNT)
             g_params_list[i]->heur_index = goal_count_index;
+        else if (g_params_list[i]->heur == MRW_Parameters::PDB)
+            g_params_list[i]->heur_index = pdb_index;
+        else if (g_params_list[i]->heur == MRW_Parameters::CG)
+            g_params_list[i]->heur_index = cg_index;
     }
     
     if(mrw_fd_ff_heuristic) {    
-        engine->add_heuristic(new FDFFHeuristic(axiom_eval));
+        heuristics.push_back(new FDFFHeuristic(axiom_eval));
     }  
     if(mrw_landmarks_heuristic) {
         LandmarksCountHeuristic *mrw_lm_heur = new LandmarksCountHeuristic(*g_lgraph,
         		need_lm_preferred, new FFHeuristic);
-		engine->add_heuristic(mrw_lm_heur);
+		heuristics.push_back(mrw_lm_heur);
     } 
     if(mrw_lama_ff_heuristic) {
-        engine->add_heuristic(new FFHeuristic);
+        heuristics.push_back(new FFHeuristic);
     }
     if(mrw_lama_ff_s_heuristic) {
-        engine->add_heuristic(new LAMA_FFS_Heuristic(new FFHeuristic));
+        heuristics.push_back(new LAMA_FFS_Heuristic(new FFHeuristic));
     }
     if(mrw_lama_ff_c_heuristic) {
-        engine->add_heuristic(new LAMA_FFC_Heuristic(new FFHeuristic));
+        heuristics.push_back(new LAMA_FFC_Heuristic(new FFHeuristic));
     }
     if(mrw_blind_heuristic) {
-        engine->add_heuristic(new BlindSearchHeuristic);
+        heuristics.push_back(new BlindSearchHeuristic);
     }
     if(mrw_goal_count_heuristic) {
-    	engine->add_heuristic(new GoalCountHeuristic);
+    	heuristics.push_back(new GoalCountHeuristic);
+    }
+    if(mrw_pdb_heuristic) {
+    	heuristics.push_back(new PDBHeuristic(*g_pdb_collection));
+    }
+    if(mrw_cg_heuristic) {
+    	heuristics.push_back(new CGHeuristic);
     }
 }
 
@@ -5,12 +5,13 @@
 #include "globals.h"
 #include "string.h"
 
-struct mrw_thread_data{
-   int  seed;
-   string name;
-};
+class MRW;
 
 void run_mrw_search(bool other_threads);
-void *run_mrw_thread(void *data);
+// an mrw engine with its heuristics, whose random streams are those of the
+// given thread index
+MRW *create_engine(int thread, UCB *learner, const string &name);
+// a parameter learner for the mrw thread with the given index
+UCB *create_learner(int thread);
 
 #endif
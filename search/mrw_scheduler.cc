@@ -0,0 +1,177 @@
+#include "mrw_scheduler.h"
+
+#include "mrw.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+
+MRWScheduler::MRWScheduler(int max_workers) {
+    queues.resize(max_workers < 1 ? 1 : max_workers);
+    for(int i = 0; i < queues.size(); i++)
+        pthread_mutex_init(&queues[i].mutex, NULL);
+    num_workers = 0;
+    num_engines = 0;
+    num_waiting = 0;
+
+    pthread_mutex_init(&idle_mutex, NULL);
+    pthread_cond_init(&work_available, NULL);
+    num_idle = 0;
+    next_queue = 0;
+}
+
+MRWScheduler::~MRWScheduler() {
+    for(int i = 0; i < threads.size(); i++)
+        pthread_join(threads[i], NULL);
+
+    pthread_cond_destroy(&work_available);
+    pthread_mutex_destroy(&idle_mutex);
+    for(int i = 0; i < queues.size(); i++)
+        pthread_mutex_destroy(&queues[i].mutex);
+}
+
+void MRWScheduler::add_engine(MRW *engine) {
+    __sync_fetch_and_add(&num_engines, 1);
+    queue_engine(engine);
+}
+
+void MRWScheduler::queue_engine(MRW *engine) {
+    // Engines may be added while the workers run, so the queue is chosen
+    // under the idle mutex and the idle workers are woken up.
+    pthread_mutex_lock(&idle_mutex);
+
+    // the engines are spread over the queues, the workers even them out
+    WorkerQueue &queue = queues[next_queue];
+    next_queue = (next_queue + 1) % queues.size();
+    pthread_mutex_lock(&queue.mutex);
+    queue.engines.push_back(engine);
+    pthread_mutex_unlock(&queue.mutex);
+    __sync_fetch_and_add(&num_waiting, 1);
+
+    pthread_cond_broadcast(&work_available);
+    pthread_mutex_unlock(&idle_mutex);
+}
+
+void MRWScheduler::start_workers(int n) {
+    for(int i = 0; i < n; i++) {
+        pthread_t thread;
+        int rc = pthread_create(&thread, NULL, worker_main, (void *)this);
+        if(rc) {
+            cerr << "ERROR: Return code from pthread_create is " << rc << endl;
+            exit(-1);
+        }
+        threads.push_back(thread);
+    }
+}
+
+void *MRWScheduler::worker_main(void *data) {
+    ((MRWScheduler *)data)->work();
+    return NULL;
+}
+
+void MRWScheduler::work() {
+    int worker = __sync_fetch_and_add(&num_workers, 1);
+    assert(worker < queues.size());
+
+    while(true) {
+        MRW *engine = wait_for_engine(worker);
+        if(engine == 0)
+            return;
+        if(engine->search_step() == SearchEngine::IN_PROGRESS)
+            push(worker, engine);
+        else
+            finish(engine);
+    }
+}
+
+void MRWScheduler::work_or_run(EngineFactory &factory) {
+    // The count of the new engine is taken before it is created, so that no
+    // other thread can see the engines done in between and the check cannot
+    // be outdated by the time the engine is queued. Workers that find no
+    // waiting engine in the meantime sleep until it is queued.
+    if(__sync_bool_compare_and_swap(&num_engines, 0, 1))
+        queue_engine(factory.create_engine());
+    work();
+}
+
+void MRWScheduler::push(int worker, MRW *engine) {
+    WorkerQueue &queue = queues[worker];
+    pthread_mutex_lock(&queue.mutex);
+    queue.engines.push_front(engine);
+    pthread_mutex_unlock(&queue.mutex);
+
+    // An idle worker registers before it checks for waiting engines, and
+    // this checks for idle workers after the engine is counted, so at least
+    // one of the two sees the other.
+    __sync_fetch_and_add(&num_waiting, 1);
+    if(num_idle > 0) {
+        pthread_mutex_lock(&idle_mutex);
+        pthread_cond_signal(&work_available);
+        pthread_mutex_unlock(&idle_mutex);
+    }
+}
+
+MRW *MRWScheduler::pop(int worker) {
+    WorkerQueue &queue = queues[worker];
+    MRW *engine = 0;
+    pthread_mutex_lock(&queue.mutex);
+    if(!queue.engines.empty()) {
+        engine = queue.engines.front();
+        queue.engines.pop_front();
+    }
+    pthread_mutex_unlock(&queue.mutex);
+    if(engine != 0)
+        __sync_fetch_and_sub(&num_waiting, 1);
+    return engine;
+}
+
+MRW *MRWScheduler::steal(int worker) {
+    for(int i = 1; i < queues.size(); i++) {
+        WorkerQueue &queue = queues[(worker + i) % queues.size()];
+        MRW *engine = 0;
+        pthread_mutex_lock(&queue.mutex);
+        if(!queue.engines.empty()) {
+            engine = queue.engines.back();
+            queue.engines.pop_back();
+        }
+        pthread_mutex_unlock(&queue.mutex);
+        if(engine != 0) {
+            __sync_fetch_and_sub(&num_waiting, 1);
+            return engine;
+        }
+    }
+    return 0;
+}
+
+MRW *MRWScheduler::wait_for_engine(int worker) {
+    while(true) {
+        MRW *engine = pop(worker);
+        if(engine == 0)
+            engine = steal(worker);
+        if(engine != 0)
+            return engine;
+
+        pthread_mutex_lock(&idle_mutex);
+        __sync_fetch_and_add(&num_idle, 1);
+        if(num_engines == 0) {
+            __sync_fetch_and_sub(&num_idle, 1);
+            pthread_mutex_unlock(&idle_mutex);
+            return 0;
+        }
+        if(num_waiting == 0)
+            pthread_cond_wait(&work_available, &idle_mutex);
+        __sync_fetch_and_sub(&num_idle, 1);
+        pthread_mutex_unlock(&idle_mutex);
+    }
+}
+
+void MRWScheduler::finish(MRW *engine) {
+    engine->statistics();
+    if(__sync_sub_and_fetch(&num_engines, 1) == 0) {
+        pthread_mutex_lock(&idle_mutex);
+        pthread_cond_broadcast(&work_available);
+        pthread_mutex_unlock(&idle_mutex);
+    }
+}
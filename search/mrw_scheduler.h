@@ -0,0 +1,83 @@
+#ifndef MRW_SCHEDULER_H
+#define MRW_SCHEDULER_H
+
+#include <pthread.h>
+#include <deque>
+#include <vector>
+
+class MRW;
+
+// creates an engine only when the scheduler really needs it
+class EngineFactory {
+public:
+    virtual ~EngineFactory() {}
+    virtual MRW *create_engine() = 0;
+};
+
+/**
+ * Runs the steps of a set of MRW engines on a set of worker threads, so that
+ * the number of engines and the number of threads need not be the same.
+ *
+ * Each worker has a queue of the engines that are waiting for their next
+ * step. A worker takes the engine at the front of its own queue, runs one
+ * step of it and puts it back at the front, so an engine normally stays on
+ * the same thread. A worker whose queue is empty steals the engine at the
+ * back of the queue of another worker. An engine whose step blocks its
+ * thread for long, as when it runs Aras, thus does not hold up the other
+ * engines of the thread, and a thread that becomes free, like the one that
+ * ran WA*, can join the workers at any time.
+ *
+ * An engine is only in one queue while it waits, so it is never run by two
+ * workers at once.
+**/
+class MRWScheduler {
+    struct WorkerQueue {
+        pthread_mutex_t mutex;
+        std::deque<MRW *> engines;
+        // keeps the queues of different workers on different cache lines
+        char padding[64];
+    };
+
+    std::vector<WorkerQueue> queues;
+    volatile int num_workers;
+    // engines that have not finished yet
+    volatile int num_engines;
+    // engines that are waiting in a queue
+    volatile int num_waiting;
+
+    // workers without any engine to run sleep until another engine is
+    // queued or all engines are done
+    pthread_mutex_t idle_mutex;
+    pthread_cond_t work_available;
+    volatile int num_idle;
+
+    // the queue that the next added engine goes into
+    int next_queue;
+
+    std::vector<pthread_t> threads;
+
+    static void *worker_main(void *data);
+    void queue_engine(MRW *engine);
+    void push(int worker, MRW *engine);
+    MRW *pop(int worker);
+    MRW *steal(int worker);
+    MRW *wait_for_engine(int worker);
+    void finish(MRW *engine);
+
+public:
+    // at most max_workers threads ever work for the scheduler
+    MRWScheduler(int max_workers);
+    ~MRWScheduler();
+
+    void add_engine(MRW *engine);
+    // starts n worker threads
+    void start_workers(int n);
+    // the calling thread works for the scheduler until all engines are done
+    void work();
+    // like work(), but if all engines are done already, an engine of the
+    // factory is added first, so that the thread does not go without work
+    void work_or_run(EngineFactory &factory);
+    bool has_engines() const {return num_engines > 0;}
+};
+
+#endif
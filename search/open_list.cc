@@ -58,8 +58,8 @@ Entry OpenList<Entry>::remove_min() {
 }
 
 template<class Entry>
-Entry OpenList<Entry>::remove_rand_node(MTRand_int32 *rand_gen) {
-	int rand_num = rand_gen->get_32bit_int() % the_heap.size();
+Entry OpenList<Entry>::remove_rand_node(RandomStream *rand_gen) {
+	int rand_num = rand_gen->get_bounded(the_heap.size());
 	Entry ans = the_heap[rand_num].second;
 	the_heap[rand_num] = the_heap[the_heap.size()-1];
 	the_heap.pop_back();
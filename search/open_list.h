@@ -26,7 +26,7 @@
 
 #include <vector>
 #include <queue>
-#include "mtrand.h"
+#include "random_stream.h"
 
 template<class Entry>
 class OpenList {
@@ -53,7 +53,7 @@ public:
 
     void insert(pair<int, int> key, const Entry &entry);
     Entry remove_min();
-    Entry remove_rand_node(MTRand_int32 *rand_gen);
+    Entry remove_rand_node(RandomStream *rand_gen);
     void clear();
 
     bool empty() const;
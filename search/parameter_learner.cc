@@ -2,26 +2,112 @@
 #include "math.h"
 #include "globals.h"
 
-UCB::UCB(float ucb_const, bool adjusting, MTRand_int32 *r) : c(ucb_const),
+namespace {
+// 64 bit atomic operations, which need a compare-and-swap in the 32 bit build
+void atomic_add(volatile int64_t *total, int64_t value) {
+	int64_t old = *total;
+	while(true) {
+		int64_t seen = __sync_val_compare_and_swap(total, old, old + value);
+		if(seen == old)
+			return;
+		old = seen;
+	}
+}
+
+int64_t atomic_get(volatile int64_t *total) {
+	return __sync_val_compare_and_swap(total, 0, 0);
+}
+}
+
+UCBStats::UCBStats(int arms) : num_arms(arms) {
+	n = new int[num_arms];
+	finished = new int[num_arms];
+	progress = new int64_t[num_arms];
+	time = new int64_t[num_arms];
+	evals = new int64_t[num_arms];
+	for(int i = 0; i < num_arms; i++) {
+		n[i] = 0;
+		finished[i] = 0;
+		progress[i] = 0;
+		time[i] = 0;
+		evals[i] = 0;
+	}
+}
+
+UCBStats::~UCBStats() {
+	delete[] n;
+	delete[] finished;
+	delete[] progress;
+	delete[] time;
+	delete[] evals;
+}
+
+void UCBStats::add(int i, int new_n, int new_finished, int64_t new_progress,
+		int64_t new_time, int64_t new_evals) {
+	if(new_n != 0)
+		__sync_fetch_and_add(&n[i], new_n);
+	if(new_finished != 0) {
+		__sync_fetch_and_add(&finished[i], new_finished);
+		atomic_add(&progress[i], new_progress);
+		atomic_add(&time[i], new_time);
+		atomic_add(&evals[i], new_evals);
+	}
+}
+
+void UCBStats::get(int i, int &n_i, int &finished_i, int64_t &progress_i,
+		int64_t &time_i, int64_t &evals_i) const {
+	// the totals of one config may come from different merges of other
+	// threads, which only shifts them by an episode or so
+	n_i = n[i];
+	finished_i = finished[i];
+	progress_i = atomic_get(&progress[i]);
+	time_i = atomic_get(&time[i]);
+	evals_i = atomic_get(&evals[i]);
+}
+
+UCB::UCB(UCBStats *stats, float ucb_const, int reward, bool adjusting,
+		RandomStream *r) :
+		shared(stats), c(ucb_const), reward_type(reward),
 		adjust_online(adjusting), rand_gen(r) {
-	values.resize(g_params_list.size());
-	n.resize(g_params_list.size());
+	int num_arms = shared->get_num_arms();
+	values.resize(num_arms, 0);
+	n.resize(num_arms, 0);
+	finished.resize(num_arms, 0);
+	total_progress.resize(num_arms, 0);
+	total_time.resize(num_arms, 0);
+	total_evals.resize(num_arms, 0);
+	new_n.resize(num_arms, 0);
+	new_finished.resize(num_arms, 0);
+	new_progress.resize(num_arms, 0);
+	new_time.resize(num_arms, 0);
+	new_evals.resize(num_arms, 0);
+	num_walk.resize(num_arms, -1);
+	max_steps.resize(num_arms, -1);
 	total_n = 0;
+	episodes_since_merge = 0;
 	initial_num_walks = 100;
 	initial_max_steps = 1;
 
 	num_walk_ub = 2000;
 	max_steps_ub = 7;
+
+	// start from what other threads have learned so far
+	merge();
+}
+
+UCB::~UCB() {
+	delete rand_gen;
 }
 
 int UCB::get_config(){
 
 	int config_id = 0;
-	bool unused = false;
 
     // only one config, so just return it
     if(n.size() != 1) {
 
+    	compute_values();
+
     	float max = -1;
     	vector<int> arg_max_list;
     	vector<int> not_tried;
@@ -49,8 +135,7 @@ int UCB::get_config(){
 
     	if(not_tried.size() != 0){
     		// at least one of the configurations has not been tried
-    		config_id = not_tried[rand_gen->get_32bit_int() % not_tried.size()];
-    		unused = true;
+    		config_id = not_tried[rand_gen->get_bounded(not_tried.size())];
     	} else {
     		assert(!arg_max_list.empty());
 
@@ -58,23 +143,18 @@ int UCB::get_config(){
     		if(arg_max_list.size() == 1)
     			config_id = arg_max_list[0];
     		else
-    			config_id = arg_max_list[rand_gen->get_32bit_int() %
-    			                         arg_max_list.size()];
+    			config_id = arg_max_list[rand_gen->get_bounded(
+    			                         arg_max_list.size())];
     	}
-    } else if(n[config_id] == 0) { // one config that is unused
-    	unused = true;
     }
 
     if(adjust_online) {
-    	if(unused){
-    		g_params_list[config_id]->num_walk = initial_num_walks;
-    		g_params_list[config_id]->max_steps = initial_max_steps;
+    	if(num_walk[config_id] == -1){
+    		num_walk[config_id] = initial_num_walks;
+    		max_steps[config_id] = initial_max_steps;
     	} else{
-
-    		g_params_list[config_id]->num_walk = min(2*g_params_list[config_id]->num_walk,
-    				num_walk_ub);
-    		g_params_list[config_id]->max_steps = min(g_params_list[config_id]->max_steps + 1,
-    				max_steps_ub);
+    		num_walk[config_id] = min(2*num_walk[config_id], num_walk_ub);
+    		max_steps[config_id] = min(max_steps[config_id] + 1, max_steps_ub);
     	}
     }
 
@@ -82,13 +162,73 @@ int UCB::get_config(){
 	// virtual loss idea from the parallel UCT
 	// Note, is equivalent to no virtual loss in single-core version
 	n[config_id]++;
-	values[config_id] -= values[config_id]/float(n[config_id]);
+	new_n[config_id]++;
 	total_n++;
 
 	return config_id;
 }
 
-void UCB::update_value(int i, int h, int upper_bound,
+void UCB::adjust_params(int i, MRW_Parameters &params) const {
+	if(adjust_online) {
+		assert(num_walk[i] != -1);
+		params.num_walk = num_walk[i];
+		params.max_steps = max_steps[i];
+	}
+}
+
+void UCB::compute_values() {
+	if(reward_type == Shared_MRW_Parameters::PROGRESS_REWARD) {
+		// episodes that are still running count as episodes without progress
+		for(int i = 0; i < n.size(); i++) {
+			if(n[i] == 0)
+				values[i] = 0;
+			else
+				values[i] = total_progress[i] / float(UCBStats::SCALE) /
+					float(n[i]);
+		}
+		return;
+	}
+
+	vector<double> rates(n.size(), 0);
+	double max_rate = 0;
+	for(int i = 0; i < n.size(); i++) {
+		double cost = total_time[i];
+		if(reward_type == Shared_MRW_Parameters::EVAL_REWARD)
+			cost = total_evals[i];
+		if(finished[i] > 0 && cost > 0)
+			rates[i] = total_progress[i] / cost;
+		max_rate = max(max_rate, rates[i]);
+	}
+
+	// Episodes that are still running count as episodes without progress,
+	// like the temporary reward of get_config
+	for(int i = 0; i < n.size(); i++) {
+		if(n[i] == 0 || max_rate == 0)
+			values[i] = 0;
+		else
+			values[i] = rates[i] / max_rate * finished[i] / float(n[i]);
+	}
+}
+
+void UCB::merge() {
+	total_n = 0;
+	for(int i = 0; i < n.size(); i++) {
+		shared->add(i, new_n[i], new_finished[i], new_progress[i],
+				new_time[i], new_evals[i]);
+		new_n[i] = 0;
+		new_finished[i] = 0;
+		new_progress[i] = 0;
+		new_time[i] = 0;
+		new_evals[i] = 0;
+
+		shared->get(i, n[i], finished[i], total_progress[i], total_time[i],
+				total_evals[i]);
+		total_n += n[i];
+	}
+	episodes_since_merge = 0;
+}
+
+void UCB::update_value(int i, int h, int upper_bound, double time, int evals,
 		const string &thread_name){
 	// First the heuristic value is mapped to the range [0 1]
 	// then it is used to update the average value
@@ -105,14 +245,26 @@ void UCB::update_value(int i, int h, int upper_bound,
 			str = "MHA";
 		cout << str << "-" << g_params_list[var]->length_walk
 				<< ":"<< n[var] << " ";
+		if(reward_type != Shared_MRW_Parameters::PROGRESS_REWARD)
+			cout << "(" << total_time[var] / float(UCBStats::SCALE) << "s, "
+					<< total_evals[var] << " evals) ";
 	}
 	cout << endl;
 	float reward = 1;
 	if(upper_bound != 0)
 	    reward = (upper_bound - h)/float(upper_bound);
-	values[i] += reward/float(n[i]);
-}
-
-
 
+	int64_t progress = int64_t(reward * UCBStats::SCALE + 0.5);
+	int64_t time_units = int64_t(time * UCBStats::SCALE + 0.5);
+	finished[i]++;
+	total_progress[i] += progress;
+	total_time[i] += time_units;
+	total_evals[i] += evals;
+	new_finished[i]++;
+	new_progress[i] += progress;
+	new_time[i] += time_units;
+	new_evals[i] += evals;
 
+	if(++episodes_since_merge >= MERGE_PERIOD)
+		merge();
+}
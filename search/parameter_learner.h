@@ -3,18 +3,77 @@
 #include "mrw_parameters.h"
 #include <vector>
 #include <stdlib.h>
+#include <stdint.h>
 #include <cassert>
-#include "mtrand.h"
+#include "random_stream.h"
 
 using namespace std;
 
+/**
+ * The statistics of the configs over all MRW threads. Threads only add to
+ * them, with atomic additions, and read them when they merge, so there is no
+ * lock. Progress and time are kept as integer multiples of 1/SCALE. Their
+ * totals and those of the evaluations grow with every episode of every
+ * thread, so they are 64 bit, which the 32 bit build adds to and reads by
+ * compare-and-swap.
+**/
+class UCBStats{
+	int num_arms;
+	volatile int *n;           // the number of times each config is used
+	volatile int *finished;    // the number of finished episodes
+	volatile int64_t *progress;
+	volatile int64_t *time;    // CPU seconds
+	volatile int64_t *evals;   // evaluated walk endpoints
+public:
+	enum {SCALE = 10000};
+
+	UCBStats(int arms);
+	~UCBStats();
+
+	int get_num_arms() const {return num_arms;}
+	void add(int i, int new_n, int new_finished, int64_t new_progress,
+			int64_t new_time, int64_t new_evals);
+	void get(int i, int &n_i, int &finished_i, int64_t &progress_i,
+			int64_t &time_i, int64_t &evals_i) const;
+};
+
+/**
+ * The UCB learner of one MRW thread. It selects configs from its own view of
+ * the statistics, which are those of g_ucb_stats when it last merged with
+ * them plus its own episodes since then, so selection never waits on other
+ * threads. Its episodes are added to the shared statistics every
+ * MERGE_PERIOD episodes.
+**/
 class UCB{
 private:
+	UCBStats *shared;
+
+	// the view of this thread
 	vector<float> values;      // the average reward value for each config
 	vector<int> n;             // the number of times each config is used
 	int total_n;               // total_n = n[0] + n[1] + ... + n[n.size() - 1 ]
+	vector<int> finished;
+	vector<int64_t> total_progress;
+	vector<int64_t> total_time;
+	vector<int64_t> total_evals;
+
+	// what this thread added to the view since its last merge
+	vector<int> new_n;
+	vector<int> new_finished;
+	vector<int64_t> new_progress;
+	vector<int64_t> new_time;
+	vector<int64_t> new_evals;
+	int episodes_since_merge;
 
 	float c;                   // The exploration weight
+	int reward_type;           // one of the Shared_MRW_Parameters rewards
+
+	// sets values to the average progress of each config, or for the rate
+	// rewards to its progress per unit of cost relative to the fastest config
+	// so that they stay in [0 1]
+	void compute_values();
+	// adds the new statistics to the shared ones and reloads the view
+	void merge();
 
 	int num_walk_ub;           // An upper bound for num_walks
 	int max_steps_ub;          // An upper bound for max_steps
@@ -23,12 +82,26 @@ private:
 	int initial_max_steps;
 
 	bool adjust_online;
-    MTRand_int32 *rand_gen;
+	// the adjusted num_walk and max_steps of each config, -1 while this
+	// thread has not used it
+	vector<int> num_walk;
+	vector<int> max_steps;
+    RandomStream *rand_gen;
 
 public:
-	UCB(float ucb_const, bool adjusting, MTRand_int32 *r);
+	enum {MERGE_PERIOD = 4};
+
+	UCB(UCBStats *stats, float ucb_const, int reward, bool adjusting,
+			RandomStream *r);
+	~UCB();
 	int get_config();
-	void update_value(int i, int h, int upper_bound, const string &thread_name);
+	// Ends an episode of config i, which got from upper_bound down to h
+	// using time CPU seconds and evals walk endpoint evaluations
+	void update_value(int i, int h, int upper_bound, double time, int evals,
+			const string &thread_name);
+	// sets the parameters that are adjusted online to those of this thread
+	// for config i
+	void adjust_params(int i, MRW_Parameters &params) const;
 };
 
 #endif /*MRW_H_*/
@@ -0,0 +1,393 @@
+#include "pdb_heuristic.h"
+
+#include "globals.h"
+#include "operator.h"
+#include "priority_queues.h"
+#include "state.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace std;
+
+/**
+ * Enumerates the abstract states of a pattern that agree with a partial
+ * assignment to the pattern variables, together with their numbers.
+**/
+class AbstractStateIterator {
+    const vector<int> &domain;
+    const vector<int> &multipliers;
+    vector<int> free_vars;
+public:
+    vector<int> values;
+    int index;
+
+    AbstractStateIterator(const vector<int> &dom, const vector<int> &mult,
+                          const vector<int> &fixed)
+        : domain(dom), multipliers(mult), values(dom.size(), 0), index(0) {
+        for(int i = 0; i < domain.size(); i++) {
+            if(fixed[i] == -1) {
+                free_vars.push_back(i);
+            } else {
+                values[i] = fixed[i];
+                index += multipliers[i] * fixed[i];
+            }
+        }
+    }
+
+    // moves to the next state, returns false after the last one
+    bool next() {
+        for(int i = 0; i < free_vars.size(); i++) {
+            int var = free_vars[i];
+            if(++values[var] < domain[var]) {
+                index += multipliers[var];
+                return true;
+            }
+            index -= multipliers[var] * (domain[var] - 1);
+            values[var] = 0;
+        }
+        return false;
+    }
+};
+
+/**
+ * An operator restricted to the pattern variables. An effect whose
+ * conditions mention other variables may or may not fire.
+**/
+struct AbstractOperator {
+    struct Effect {
+        int var;
+        int post;
+        vector<pair<int, int> > cond;
+        bool may_not_fire;
+    };
+    vector<int> pre;
+    vector<Effect> effects;
+    int num_uncertain;
+    int cost;
+};
+
+// the position of var in pattern, -1 if it is not part of it
+static int pattern_position(const vector<int> &pattern, int var) {
+    for(int i = 0; i < pattern.size(); i++)
+        if(pattern[i] == var)
+            return i;
+    return -1;
+}
+
+static bool add_precondition(vector<int> &pre, int var, int value) {
+    if(var == -1)
+        return true;
+    if(pre[var] != -1 && pre[var] != value)
+        return false;
+    pre[var] = value;
+    return true;
+}
+
+// false if the operator cannot change the pattern or is never applicable
+static bool project_operator(const Operator &op, const vector<int> &pattern,
+                             AbstractOperator &result) {
+    const vector<Prevail> &prevail = op.get_prevail();
+    const vector<PrePost> &pre_post = op.get_pre_post();
+
+    result.pre.assign(pattern.size(), -1);
+    result.effects.clear();
+    result.num_uncertain = 0;
+    result.cost = op.get_true_cost();
+
+    for(int i = 0; i < prevail.size(); i++)
+        if(!add_precondition(result.pre,
+                pattern_position(pattern, prevail[i].var), prevail[i].prev))
+            return false;
+
+    for(int i = 0; i < pre_post.size(); i++) {
+        int var = pattern_position(pattern, pre_post[i].var);
+        if(var == -1)
+            continue;
+        if(pre_post[i].pre != -1 &&
+           !add_precondition(result.pre, var, pre_post[i].pre))
+            return false;
+
+        AbstractOperator::Effect effect;
+        effect.var = var;
+        effect.post = pre_post[i].post;
+        effect.may_not_fire = false;
+        const vector<Prevail> &cond = pre_post[i].cond;
+        for(int j = 0; j < cond.size(); j++) {
+            int cond_var = pattern_position(pattern, cond[j].var);
+            if(cond_var == -1)
+                effect.may_not_fire = true;
+            else
+                effect.cond.push_back(make_pair(cond_var, cond[j].prev));
+        }
+        if(effect.may_not_fire)
+            result.num_uncertain++;
+        result.effects.push_back(effect);
+    }
+    return !result.effects.empty();
+}
+
+// The successors of the abstract state it points to, one for every way the
+// effects that may or may not fire can turn out
+static void generate_successors(const AbstractOperator &op,
+                                const AbstractStateIterator &it,
+                                const vector<int> &multipliers,
+                                vector<int> &values,
+                                vector<int> &successors) {
+    successors.clear();
+    for(int outcome = 0; outcome < (1 << op.num_uncertain); outcome++) {
+        int succ = it.index;
+        int uncertain = 0;
+        values = it.values;
+        for(int i = 0; i < op.effects.size(); i++) {
+            const AbstractOperator::Effect &effect = op.effects[i];
+            bool fires = true;
+            for(int j = 0; j < effect.cond.size() && fires; j++)
+                fires = (it.values[effect.cond[j].first] == effect.cond[j].second);
+            if(effect.may_not_fire)
+                fires = fires && (outcome & (1 << uncertain++));
+            if(fires) {
+                succ += multipliers[effect.var] *
+                    (effect.post - values[effect.var]);
+                values[effect.var] = effect.post;
+            }
+        }
+        if(succ != it.index)
+            successors.push_back(succ);
+    }
+}
+
+PatternDatabase::PatternDatabase(const vector<int> &p) : pattern(p) {
+    num_states = 1;
+    for(int i = 0; i < pattern.size(); i++) {
+        multipliers.push_back(num_states);
+        num_states *= g_variable_domain[pattern[i]];
+    }
+}
+
+void PatternDatabase::build_transitions() {
+    vector<int> domain;
+    for(int i = 0; i < pattern.size(); i++)
+        domain.push_back(g_variable_domain[pattern[i]]);
+
+    vector<AbstractOperator> operators;
+    AbstractOperator op;
+    for(int i = 0; i < g_operators.size(); i++)
+        if(project_operator(g_operators[i], pattern, op))
+            operators.push_back(op);
+
+    // The transitions are generated twice, first to count those into each
+    // state and then to store them, which saves holding them all in a
+    // temporary list.
+    vector<int> values, successors;
+    first_transition.assign(num_states + 1, 0);
+    for(int i = 0; i < operators.size(); i++) {
+        AbstractStateIterator it(domain, multipliers, operators[i].pre);
+        do {
+            generate_successors(operators[i], it, multipliers, values,
+                                successors);
+            for(int j = 0; j < successors.size(); j++)
+                first_transition[successors[j] + 1]++;
+        } while(it.next());
+    }
+    for(int s = 0; s < num_states; s++)
+        first_transition[s + 1] += first_transition[s];
+
+    transition_source.resize(first_transition[num_states]);
+    transition_cost.resize(first_transition[num_states]);
+    vector<int> next_free(first_transition.begin(), first_transition.end() - 1);
+    for(int i = 0; i < operators.size(); i++) {
+        AbstractStateIterator it(domain, multipliers, operators[i].pre);
+        do {
+            generate_successors(operators[i], it, multipliers, values,
+                                successors);
+            for(int j = 0; j < successors.size(); j++) {
+                int pos = next_free[successors[j]]++;
+                transition_source[pos] = it.index;
+                transition_cost[pos] = operators[i].cost;
+            }
+        } while(it.next());
+    }
+}
+
+void PatternDatabase::compute_distances() {
+    vector<int> domain;
+    vector<int> goal(pattern.size(), -1);
+    for(int i = 0; i < pattern.size(); i++)
+        domain.push_back(g_variable_domain[pattern[i]]);
+    for(int i = 0; i < g_goal.size(); i++) {
+        int var = pattern_position(pattern, g_goal[i].first);
+        if(var != -1)
+            goal[var] = g_goal[i].second;
+    }
+
+    int max_cost = 0;
+    for(int i = 0; i < transition_cost.size(); i++)
+        max_cost = max(max_cost, transition_cost[i]);
+
+    MonotoneQueue<int> queue;
+    queue.set_max_cost(max_cost);
+    distances.assign(num_states, -1);
+    AbstractStateIterator it(domain, multipliers, goal);
+    do {
+        distances[it.index] = 0;
+        queue.push(0, it.index);
+    } while(it.next());
+
+    while(!queue.empty()) {
+        pair<int, int> top = queue.pop();
+        int distance = top.first;
+        int state = top.second;
+        if(distance > distances[state])
+            continue;
+        for(int i = first_transition[state]; i < first_transition[state + 1]; i++) {
+            int pred = transition_source[i];
+            int pred_distance = distance + transition_cost[i];
+            if(distances[pred] == -1 || pred_distance < distances[pred]) {
+                distances[pred] = pred_distance;
+                queue.push(pred_distance, pred);
+            }
+        }
+    }
+}
+
+void PatternDatabase::build() {
+    build_transitions();
+    compute_distances();
+
+    // the transitions are only needed to build the table
+    vector<int>().swap(first_transition);
+    vector<int>().swap(transition_source);
+    vector<int>().swap(transition_cost);
+}
+
+int PatternDatabase::get_distance(const State &state) const {
+    int index = 0;
+    for(int i = 0; i < pattern.size(); i++)
+        index += multipliers[i] * state[pattern[i]];
+    return distances[index];
+}
+
+namespace {
+class BuildPDBsTask : public ParallelTask {
+    vector<PatternDatabase *> &pdbs;
+public:
+    BuildPDBsTask(vector<PatternDatabase *> &p) : pdbs(p) {}
+    virtual void run(int item, int) {
+        pdbs[item]->build();
+    }
+};
+}
+
+PDBCollection::PDBCollection(int size_kb) {
+    int max_entries = (size_kb * 1024) / sizeof(int);
+    vector<vector<int> > patterns;
+    select_patterns(max_entries, patterns);
+    for(int i = 0; i < patterns.size(); i++)
+        pdbs.push_back(new PatternDatabase(patterns[i]));
+
+    BuildPDBsTask task(pdbs);
+    if(g_thread_pool != NULL) {
+        g_thread_pool->run(task, pdbs.size());
+    } else {
+        for(int i = 0; i < pdbs.size(); i++)
+            task.run(i, 0);
+    }
+}
+
+PDBCollection::~PDBCollection() {
+    for(int i = 0; i < pdbs.size(); i++)
+        delete pdbs[i];
+}
+
+int PDBCollection::get_num_entries() const {
+    int entries = 0;
+    for(int i = 0; i < pdbs.size(); i++)
+        entries += pdbs[i]->get_num_states();
+    return entries;
+}
+
+void PDBCollection::select_patterns(int max_entries,
+                                    vector<vector<int> > &patterns) const {
+    vector<int> goal_vars;
+    for(int i = 0; i < g_goal.size(); i++)
+        if(g_axiom_layers[g_goal[i].first] == -1)
+            goal_vars.push_back(g_goal[i].first);
+    if(goal_vars.empty())
+        return;
+
+    // every goal variable gets the same share of the budget, even if it ends
+    // up in the pattern of another one
+    int max_states = max_entries / goal_vars.size();
+    if(max_states > MAX_PDB_STATES)
+        max_states = MAX_PDB_STATES;
+
+    vector<bool> used(g_variable_domain.size(), false);
+    for(int i = 0; i < goal_vars.size(); i++) {
+        int var = goal_vars[i];
+        if(used[var] || g_variable_domain[var] > max_states)
+            continue;
+        vector<int> pattern;
+        grow_pattern(var, max_states, used, pattern);
+        patterns.push_back(pattern);
+    }
+}
+
+void PDBCollection::grow_pattern(int goal_var, int max_states,
+                                 vector<bool> &used, vector<int> &pattern) const {
+    int num_vars = g_variable_domain.size();
+    pattern.push_back(goal_var);
+    used[goal_var] = true;
+    int num_states = g_variable_domain[goal_var];
+
+    // number of operators that make the pattern depend on each variable
+    vector<int> weight(num_vars, 0);
+    while(true) {
+        for(int var = 0; var < num_vars; var++)
+            weight[var] = 0;
+        for(int var = 0; var < num_vars; var++) {
+            if(used[var])
+                continue;
+            const vector<pair<int, int> > &succ = g_causal_graph[var];
+            for(int i = 0; i < succ.size(); i++)
+                if(pattern_position(pattern, succ[i].first) != -1)
+                    weight[var] += succ[i].second;
+        }
+
+        int best = -1;
+        for(int var = 0; var < num_vars; var++) {
+            if(used[var] || weight[var] == 0 || g_axiom_layers[var] != -1 ||
+               num_states > max_states / g_variable_domain[var])
+                continue;
+            if(best == -1 || weight[var] > weight[best])
+                best = var;
+        }
+        if(best == -1)
+            break;
+        pattern.push_back(best);
+        used[best] = true;
+        num_states *= g_variable_domain[best];
+    }
+    sort(pattern.begin(), pattern.end());
+}
+
+PDBHeuristic::PDBHeuristic(const PDBCollection &collection)
+    : pdbs(collection) {
+}
+
+PDBHeuristic::~PDBHeuristic() {
+}
+
+int PDBHeuristic::compute_heuristic(const State &state) {
+    int h = 0;
+    for(int i = 0; i < pdbs.get_num_pdbs(); i++) {
+        int distance = pdbs.get_pdb(i).get_distance(state);
+        if(distance == -1)
+            return DEAD_END;
+        h += distance;
+        if(h > get_cutoff())
+            return PRUNED;
+    }
+    return h;
+}
@@ -0,0 +1,97 @@
+#ifndef PDB_HEURISTIC_H
+#define PDB_HEURISTIC_H
+
+#include "heuristic.h"
+
+#include <vector>
+
+class State;
+
+/**
+ * The goal distances of all states of the projection of the task onto a few
+ * variables, the pattern. Preconditions and effect conditions on other
+ * variables are ignored, so the distances never overestimate the cost of
+ * reaching the goal values of the pattern. Derived variables are never part
+ * of a pattern.
+ *
+ * An abstract state is numbered by summing up value * multiplier over the
+ * pattern, so a lookup costs one multiplication per pattern variable.
+**/
+class PatternDatabase {
+    std::vector<int> pattern;
+    std::vector<int> multipliers;
+    int num_states;
+
+    // -1 if the goal cannot be reached
+    std::vector<int> distances;
+
+    // reverse transitions of the projection. The transitions leading into
+    // abstract state s are those from first_transition[s] to
+    // first_transition[s + 1].
+    std::vector<int> first_transition;
+    std::vector<int> transition_source;
+    std::vector<int> transition_cost;
+
+    void build_transitions();
+    void compute_distances();
+public:
+    PatternDatabase(const std::vector<int> &pattern);
+
+    // fills the table, may be called concurrently for different databases
+    void build();
+
+    const std::vector<int> &get_pattern() const {return pattern;}
+    int get_num_states() const {return num_states;}
+    int get_distance(const State &state) const;
+};
+
+/**
+ * Pattern databases for disjoint patterns that together cover the goal
+ * variables, which are shared by all PDB heuristics.
+ *
+ * Each pattern starts with a goal variable that is not covered yet and
+ * grows along the causal graph, adding the variable that most operators
+ * make the pattern depend on, as long as the table stays within its share
+ * of the memory budget. The tables are built by the threads of
+ * g_thread_pool.
+**/
+class PDBCollection {
+    std::vector<PatternDatabase *> pdbs;
+
+    void select_patterns(int max_entries,
+                         std::vector<std::vector<int> > &patterns) const;
+    void grow_pattern(int goal_var, int max_states, std::vector<bool> &used,
+                      std::vector<int> &pattern) const;
+public:
+    enum {DEFAULT_KB = 4096};
+    // no single table gets more entries than this, as the transitions
+    // needed while building it take several times as much memory
+    enum {MAX_PDB_STATES = 1 << 18};
+
+    PDBCollection(int size_kb);
+    ~PDBCollection();
+
+    int get_num_pdbs() const {return pdbs.size();}
+    const PatternDatabase &get_pdb(int i) const {return *pdbs[i];}
+    int get_num_entries() const;
+};
+
+/**
+ * Sum of the goal distances in the shared pattern databases. As different
+ * patterns may need the same operators, this is not admissible. Computing it
+ * takes a few table lookups, so it is cheaper than looking it up in the
+ * heuristic cache.
+**/
+class PDBHeuristic : public Heuristic {
+    const PDBCollection &pdbs;
+protected:
+    virtual int compute_heuristic(const State &state);
+public:
+    PDBHeuristic(const PDBCollection &collection);
+    ~PDBHeuristic();
+
+    virtual bool is_worth_caching() {return false;}
+    virtual std::string get_heuristic_name() {return "PDB";}
+};
+
+#endif
@@ -23,7 +23,7 @@
 using namespace std;
 
 PlanBooster::PlanBooster(AxiomEvaluator *a, int memory_limit_, int time_limit_,
-		MTRand_int32 *r, string n, bool single_iter) : axiom_eval(a),
+		RandomStream *r, string n, bool single_iter) : axiom_eval(a),
 		memory_limit(memory_limit_), time_limit(time_limit_), rand_gen(r) ,
 		name(n), single_iteration(single_iter){
 	//wrapper = 0;
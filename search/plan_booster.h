@@ -9,7 +9,7 @@
 #include "heuristic.h"
 #include "search_space.h"
 #include "planner_wrapper.h"
-#include "mtrand.h"
+#include "random_stream.h"
 
 using namespace std;
 
@@ -64,7 +64,7 @@ class PlanBooster
 	int time_limit;
 	int time_keeping_counter;
 	Timer* timer;
-    MTRand_int32 *rand_gen;
+    RandomStream *rand_gen;
 
     string name;
 	bool single_iteration;
@@ -109,7 +109,7 @@ public:
 	vector<const Operator*> any_time_neighborhood_search_star(ifstream& in, bool build_regression_graph, bool ae);
 
 	PlanBooster(AxiomEvaluator *a, int mem_limit, int time_limit,
-			MTRand_int32 *r, string n, bool single_iteration);
+			RandomStream *r, string n, bool single_iteration);
 	virtual ~PlanBooster();
 };
 
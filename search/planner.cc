@@ -26,12 +26,17 @@
 #include "string.h"
 #include "wa_runner.h"
 #include "mrw_runner.h"
+#include "heuristic_cache.h"
+#include "dead_end_store.h"
+#include "thread_pool.h"
+#include "pdb_heuristic.h"
 
 #include "command_line_parsing.h"
 
 #include <cassert>
 #include <iostream>
 #include <fstream>
+#include <iterator>
 #include <sstream>
 #include <vector>
 #include <sys/times.h>
@@ -40,6 +45,7 @@
 using namespace std;
 
 bool are_generating_landmarks(WA_Star_Parameters *wa_star_params);
+bool are_using_pdbs();
 
 int main(int argc, const char **argv) {
     
@@ -62,7 +68,7 @@ int main(int argc, const char **argv) {
 	} else if(g_params_list.size() > 0 && g_mrw_shared == NULL) {
 		cout << "Using default version of shared MRW" << endl << endl;
 		g_mrw_shared = new Shared_MRW_Parameters;
-	} else if(wa_star_params == NULL) { // Run MRW as default if no stdin values
+	} else if(g_params_list.empty() && wa_star_params == NULL) { // Run MRW as default if no stdin values
 		cout << "Using single default version of MRW" << endl << endl;
 		MRW_Parameters* default_mrw_params = new MRW_Parameters();
 		g_params_list.push_back(default_mrw_params);
@@ -100,15 +106,47 @@ int main(int argc, const char **argv) {
 		cout << "Starting normal solver." << endl;
 	}
 
+	// The search threads are idle until preprocessing is done, so it can use
+	// as many threads
+	int num_search_threads = g_params_list.empty() ? 1 :
+			max(g_mrw_shared->num_threads, g_mrw_shared->num_workers) *
+			g_mrw_shared->walk_threads;
+	g_thread_pool = new ThreadPool(num_search_threads);
+
+	// The task is read into memory first, so that the landmarks graph cache
+	// can recognise it
+	string task((istreambuf_iterator<char>(cin)), istreambuf_iterator<char>());
+	if(!g_lm_cache_file.empty())
+		compute_task_fingerprint(task, reasonable_orders);
+	istringstream task_in(task);
+
 	// Read input and generate landmarks
 	bool generate_landmarks = are_generating_landmarks(wa_star_params);
 	g_lgraph = NULL;
 	Timer landmark_timer;
-	read_everything(cin, generate_landmarks, reasonable_orders);
+	read_everything(task_in, generate_landmarks, reasonable_orders);
     landmark_timer.stop();
 	if(g_lgraph != NULL) 
 		cout << "Landmarks generation time: " << landmark_timer << endl;
 
+	if(are_using_pdbs()) {
+		Timer pdb_timer;
+		int pdb_kb = g_pdb_kb == -1 ? PDBCollection::DEFAULT_KB : g_pdb_kb;
+		g_pdb_collection = new PDBCollection(pdb_kb);
+		pdb_timer.stop();
+		cout << "Built " << g_pdb_collection->get_num_pdbs()
+			<< " pattern database(s) with " << g_pdb_collection->get_num_entries()
+			<< " entries in " << pdb_timer << endl;
+	}
+
+	if(g_h_cache_kb != -1) {
+		g_heuristic_cache = new HeuristicCache(g_h_cache_kb, g_h_cache_policy);
+		cout << "Heuristic cache with " << g_heuristic_cache->get_num_entries()
+			<< " entries" << endl;
+	}
+	if(g_dead_end_store_kb != -1)
+		g_dead_end_store = new DeadEndStore(g_dead_end_store_kb);
+
 	/* Still need to do something with this
 	if(g_init_trajectory_file != NULL &&
 	    !parse_trajectory_file(g_init_trajectory_file)) {
@@ -161,3 +199,11 @@ bool are_generating_landmarks(WA_Star_Parameters *wa_star_params) {
     return false;
 }
 
+bool are_using_pdbs() {
+    for(int i = 0; i < g_params_list.size(); i++) {
+        if(g_params_list[i]->heur == MRW_Parameters::PDB)
+            return true;
+    }
+    return false;
+}
+
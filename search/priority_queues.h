@@ -0,0 +1,118 @@
+#ifndef PRIORITY_QUEUES_H
+#define PRIORITY_QUEUES_H
+
+#include <cassert>
+#include <utility>
+#include <vector>
+
+/**
+ * A priority queue for Dijkstra-like relaxed explorations. Keys are
+ * non-negative and a pushed key is never smaller than the last popped one.
+ *
+ * The queue is either a bucket queue, with one bucket per key, or a radix
+ * heap. The bucket queue is the fastest choice for small action costs, but
+ * has to scan every key up to the largest one. The radix heap keeps 33
+ * buckets, bucket i holding the keys whose highest bit that differs from the
+ * last popped key is bit i - 1. An entry moves to a lower bucket at most 32
+ * times, so its cost does not depend on the size of the keys.
+ *
+ * Entries with equal keys are popped last in, first out.
+**/
+template<class Value>
+class MonotoneQueue {
+    typedef std::pair<int, Value> Entry;
+
+    bool use_radix;
+    int num_entries;
+
+    // bucket queue
+    std::vector<std::vector<Value> > buckets;
+    int current_key;
+
+    // radix heap
+    enum {RADIX_BUCKETS = 33};
+    std::vector<Entry> radix_buckets[RADIX_BUCKETS];
+    int last_key;
+
+    static int radix_bucket(int key, int last) {
+        if(key == last)
+            return 0;
+        return 32 - __builtin_clz(static_cast<unsigned int>(key ^ last));
+    }
+
+    void refill_radix_bucket_0() {
+        int i = 1;
+        while(radix_buckets[i].empty())
+            i++;
+        std::vector<Entry> &bucket = radix_buckets[i];
+        int min_key = bucket[0].first;
+        for(int j = 1; j < bucket.size(); j++)
+            if(bucket[j].first < min_key)
+                min_key = bucket[j].first;
+        last_key = min_key;
+        for(int j = 0; j < bucket.size(); j++)
+            radix_buckets[radix_bucket(bucket[j].first, last_key)].push_back(bucket[j]);
+        bucket.clear();
+    }
+
+public:
+    MonotoneQueue() : use_radix(false), num_entries(0), current_key(0), last_key(0) {}
+
+    // Chooses the representation for explorations whose action costs are
+    // at most max_cost, only allowed on an empty queue. With large costs a
+    // bucket per key would mostly be scanned empty, so a radix heap is used
+    // above MAX_BUCKET_QUEUE_COST.
+    enum {MAX_BUCKET_QUEUE_COST = 8};
+    void set_max_cost(int max_cost) {
+        assert(empty());
+        use_radix = max_cost > MAX_BUCKET_QUEUE_COST;
+    }
+    bool uses_radix() const {return use_radix;}
+
+    bool empty() const {return num_entries == 0;}
+
+    void clear() {
+        // the buckets keep their memory for the next exploration
+        for(int i = 0; i < buckets.size(); i++)
+            buckets[i].clear();
+        for(int i = 0; i < RADIX_BUCKETS; i++)
+            radix_buckets[i].clear();
+        num_entries = 0;
+        current_key = 0;
+        last_key = 0;
+    }
+
+    void push(int key, const Value &value) {
+        assert(key >= 0);
+        num_entries++;
+        if(use_radix) {
+            assert(key >= last_key);
+            radix_buckets[radix_bucket(key, last_key)].push_back(Entry(key, value));
+        } else {
+            assert(key >= current_key);
+            if(key >= buckets.size())
+                buckets.resize(key + 1);
+            buckets[key].push_back(value);
+        }
+    }
+
+    // removes an entry with the smallest key and returns it with its key
+    Entry pop() {
+        assert(!empty());
+        num_entries--;
+        if(use_radix) {
+            if(radix_buckets[0].empty())
+                refill_radix_bucket_0();
+            Entry result = radix_buckets[0].back();
+            radix_buckets[0].pop_back();
+            return result;
+        }
+        while(buckets[current_key].empty())
+            current_key++;
+        Entry result(current_key, buckets[current_key].back());
+        buckets[current_key].pop_back();
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,36 @@
+#include "random_stream.h"
+
+// the finalizer of a 32 bit hash, every input bit affects every output bit
+static uint32_t mix(uint32_t x) {
+	x ^= x >> 16;
+	x *= 0x7feb352dU;
+	x ^= x >> 15;
+	x *= 0x846ca68bU;
+	x ^= x >> 16;
+	return x;
+}
+
+RandomStream::RandomStream(unsigned int seed, Kind kind, int thread,
+		int slot) {
+	uint32_t key = mix(seed);
+	key = mix(key ^ uint32_t(kind));
+	key = mix(key ^ uint32_t(thread));
+	key = mix(key ^ uint32_t(slot));
+
+	// the state words are consecutive values of a splitmix sequence
+	for(int i = 0; i < 4; i++) {
+		key += 0x9e3779b9U;
+		s[i] = mix(key);
+	}
+	// xoshiro never leaves the all zero state
+	if(s[0] == 0 && s[1] == 0 && s[2] == 0 && s[3] == 0)
+		s[0] = 1;
+
+	next_double = DOUBLE_BLOCK;
+}
+
+void RandomStream::fill_doubles() {
+	for(int i = 0; i < DOUBLE_BLOCK; i++)
+		doubles[i] = get_32bit_int() * (1. / 4294967296.);   // divided by 2^32
+	next_double = 0;
+}
@@ -0,0 +1,79 @@
+#ifndef RANDOM_STREAM_H
+#define RANDOM_STREAM_H
+
+#include <stdint.h>
+
+/**
+ * A xoshiro128** generator, which keeps four words of state and takes a few
+ * shifts and multiplications per number.
+ *
+ * Every component that draws random numbers has its own stream, derived by
+ * hashing the master seed g_seed together with the kind of stream, the thread
+ * and the slot within the thread. The numbers of a stream thus only depend
+ * on the seed and on what the stream is for, not on how many other streams
+ * there are or in which order threads started.
+**/
+class RandomStream {
+public:
+	enum Kind {
+		ENGINE_STREAM,     // restart and jump points of an MRW thread
+		WALKER_STREAM,     // the walks of one walk slot of an MRW thread
+		POOL_STREAM,       // smart restarts of an MRW thread
+		LEARNER_STREAM,    // config selection of an MRW thread
+		WA_STAR_STREAM,    // open list tie-breaking and noise of WA*
+		HASH_KEY_STREAM    // the state hash keys, the same for all seeds
+	};
+
+	RandomStream(unsigned int seed, Kind kind, int thread, int slot = 0);
+
+	// returns int value in [0, 2^32)
+	uint32_t get_32bit_int() {
+		uint32_t result = rotl(s[1] * 5, 7) * 9;
+		uint32_t t = s[1] << 9;
+		s[2] ^= s[0];
+		s[3] ^= s[1];
+		s[1] ^= s[2];
+		s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = rotl(s[3], 11);
+		return result;
+	}
+
+	// returns int value in [0, bound), without the bias of taking the
+	// remainder. Lemire's method needs a division only in the rare case
+	// that the draw falls into the biased part.
+	unsigned int get_bounded(unsigned int bound) {
+		uint64_t m = uint64_t(get_32bit_int()) * bound;
+		uint32_t low = uint32_t(m);
+		if(low < bound) {
+			uint32_t threshold = (0u - bound) % bound;
+			while(low < threshold) {
+				m = uint64_t(get_32bit_int()) * bound;
+				low = uint32_t(m);
+			}
+		}
+		return uint32_t(m >> 32);
+	}
+
+	// returns double value in [0, 1). The doubles are generated in blocks,
+	// in a loop without any other work.
+	double get_double() {
+		if(next_double == DOUBLE_BLOCK)
+			fill_doubles();
+		return doubles[next_double++];
+	}
+
+private:
+	enum {DOUBLE_BLOCK = 16};
+
+	uint32_t s[4];
+	double doubles[DOUBLE_BLOCK];
+	int next_double;
+
+	static uint32_t rotl(uint32_t x, int k) {
+		return (x << k) | (x >> (32 - k));
+	}
+	void fill_doubles();
+};
+
+#endif
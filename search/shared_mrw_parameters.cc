@@ -1,12 +1,14 @@
 #include "shared_mrw_parameters.h"
 
 #include <iostream>
+#include <unistd.h>
 
 // default values for shared MRW parameters
 #define DEFAULT_RES_TYPE BASIC
 #define DEFAULT_POOL_ACT 50
 #define DEFAULT_POOL_SIZE 50
 #define DEFAULT_UCB_CONST 0.2
+#define DEFAULT_UCB_REWARD PROGRESS_REWARD
 
 #define DEFAULT_RUN_ARAS false
 #define DEFAULT_ARAS_TIME -1
@@ -19,9 +21,17 @@
 #define DEFAULT_MRW_TIME_LIMIT -1
 
 #define DEFAULT_NUM_THREADS 1
+#define DEFAULT_WALK_THREADS 1
+#define DEFAULT_SHARED_Q_WEIGHT 0
 
 using namespace std;
 
+// number of processors that are online, at least 1
+static int get_num_cores() {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores < 1 ? 1 : int(cores);
+}
+
 Shared_MRW_Parameters::Shared_MRW_Parameters() {
     set_as_defaults();
 }
@@ -31,6 +41,7 @@ void Shared_MRW_Parameters::set_as_defaults() {
     pool_size = DEFAULT_POOL_SIZE;
     act_level = DEFAULT_POOL_ACT;
     ucb_const = DEFAULT_UCB_CONST;
+    ucb_reward = DEFAULT_UCB_REWARD;
     run_aras = DEFAULT_RUN_ARAS;
     reg_aras = DEFAULT_ARAS_REG;
     fast_aras = DEFAULT_FAST_ARAS;
@@ -38,6 +49,9 @@ void Shared_MRW_Parameters::set_as_defaults() {
     aras_time_limit = DEFAULT_ARAS_TIME;
 
     num_threads = DEFAULT_NUM_THREADS;
+    walk_threads = DEFAULT_WALK_THREADS;
+    num_workers = num_threads;
+    shared_q_weight = DEFAULT_SHARED_Q_WEIGHT;
 
     dovetail = DEFAULT_DOVETAIL;
 
@@ -51,6 +65,7 @@ void Shared_MRW_Parameters::set_as_dummy() {
     pool_size = -1;
     act_level = -1;
     ucb_const = -1;
+    ucb_reward = -1;
     run_aras = false;
     reg_aras = DEFAULT_ARAS_REG;  
     fast_aras = DEFAULT_FAST_ARAS;
@@ -61,6 +76,9 @@ void Shared_MRW_Parameters::set_as_dummy() {
     dovetail = false;
 
     num_threads = -1;
+    walk_threads = -1;
+    num_workers = -1;
+    shared_q_weight = -1;
 
     mrw_time_limit = -2;
 }
@@ -75,12 +93,23 @@ void Shared_MRW_Parameters::set_unset_params() {
         act_level = DEFAULT_POOL_ACT;
     if(ucb_const == -1 && !dovetail)
         ucb_const = DEFAULT_UCB_CONST;
+    if(ucb_reward == -1)
+        ucb_reward = DEFAULT_UCB_REWARD;
     if(aras_kb_limit == -2)
         aras_kb_limit = DEFAULT_ARAS_MEM;
     if(aras_time_limit == -2)
         aras_time_limit = DEFAULT_ARAS_TIME;
     if(num_threads == -1)
     	num_threads = DEFAULT_NUM_THREADS;
+    if(walk_threads == -1)
+    	walk_threads = DEFAULT_WALK_THREADS;
+    // by default every engine has a thread of its own
+    if(num_workers == -1)
+    	num_workers = num_threads;
+    else if(num_workers == 0)
+    	num_workers = get_num_cores();
+    if(shared_q_weight == -1)
+    	shared_q_weight = DEFAULT_SHARED_Q_WEIGHT;
     if(mrw_time_limit == -2)
     	mrw_time_limit = DEFAULT_MRW_TIME_LIMIT;
 
@@ -101,6 +130,14 @@ void Shared_MRW_Parameters::print_values() {
     else
     	cout << "\tUCB Constant Value: " << ucb_const << endl;
 
+    cout << "\tUCB Reward: ";
+    if(ucb_reward == PROGRESS_REWARD)
+        cout << "PROGRESS" << endl;
+    else if(ucb_reward == TIME_REWARD)
+        cout << "TIME" << endl;
+    else if(ucb_reward == EVAL_REWARD)
+        cout << "EVALS" << endl;
+
     cout << "\tUse Aras: ";
     if(run_aras) {
         cout << "true" << endl;
@@ -134,6 +171,10 @@ void Shared_MRW_Parameters::print_values() {
     	cout << "false" << endl;
     }
     cout << "\tNum Threads: " << num_threads << endl;
+    cout << "\tWalk Threads: " << walk_threads << endl;
+    cout << "\tWorkers: " << num_workers << endl;
+    if(shared_q_weight > 0)
+    	cout << "\tShared Action Value Weight: " << shared_q_weight << endl;
     cout << "\tMRW Time Limit: ";
     if(mrw_time_limit < 0)
     	cout << "None" << endl;
@@ -285,6 +326,39 @@ bool Shared_MRW_Parameters::read_from_string(string conf_string) {
             		cerr << "Number of threads must be positive" << endl;
             		return false;
             	}
+            } else if(arg.compare("-walk_threads") == 0) {
+            	if(walk_threads != -1) {
+            		cerr << "Can't set walk threads multiple times" << endl;
+            		return false;
+            	} else if(!string_to_int(tokens[i], walk_threads))
+                    return false;
+
+            	if(walk_threads < 1) {
+            		cerr << "Number of walk threads must be positive" << endl;
+            		return false;
+            	}
+            } else if(arg.compare("-workers") == 0) {
+            	if(num_workers != -1) {
+            		cerr << "Can't set workers multiple times" << endl;
+            		return false;
+            	} else if(!string_to_int(tokens[i], num_workers))
+                    return false;
+
+            	if(num_workers < 0) {
+            		cerr << "Number of workers must not be negative" << endl;
+            		return false;
+            	}
+            } else if(arg.compare("-shared_q") == 0) {
+            	if(shared_q_weight != -1) {
+            		cerr << "Can't set shared q weight multiple times" << endl;
+            		return false;
+            	} else if(!string_to_int(tokens[i], shared_q_weight))
+                    return false;
+
+            	if(shared_q_weight < 0) {
+            		cerr << "Shared q weight must not be negative" << endl;
+            		return false;
+            	}
 
             // now consider inputs with a small finite number of string options 
             } else if(arg.compare("-res_type") == 0) {
@@ -299,6 +373,20 @@ bool Shared_MRW_Parameters::read_from_string(string conf_string) {
                     cerr << "Invalid restart type entered" << endl;
                     return false;
                 }
+            } else if(arg.compare("-ucb_reward") == 0) {
+               if(ucb_reward != -1) {
+                    cerr << "Cannot set ucb reward more than once\n";
+                    return false;
+                } else if(tokens[i].compare("PROGRESS") == 0)
+                    ucb_reward = Shared_MRW_Parameters::PROGRESS_REWARD;
+                else if(tokens[i].compare("TIME") == 0)
+                    ucb_reward = Shared_MRW_Parameters::TIME_REWARD;
+                else if(tokens[i].compare("EVALS") == 0)
+                    ucb_reward = Shared_MRW_Parameters::EVAL_REWARD;
+                else {
+                    cerr << "Invalid ucb reward entered" << endl;
+                    return false;
+                }
             // invalid input
             } else {
                 cerr << "Invalid shared MRW parameter arg of "
@@ -332,6 +420,10 @@ void Shared_MRW_Parameters::print_help_info() {
         " is changed to n for\n\t\tn in [0, infty). " <<
         DEFAULT_UCB_CONST << " by default" << endl;
     cerr << "\t\tAlternatively enter -dovetail for dovetailing" << endl;
+    cerr << "\t-ucb_reward PROGRESS|TIME|EVALS : rewards configurations for " <<
+        "the progress\n\t\tof an episode, or for their progress per CPU " <<
+        "second or per\n\t\tevaluated walk endpoint. PROGRESS by default"
+        << endl;
     cerr << "\t-run_aras : uses aras to improve plans found" << endl;
     cerr << "\t-aras_mem n : limits aras memory usage to n bytes. " <<
         "\n\t\tn in {-1}U[1, infty). -1 means no limit (is default value)"
@@ -341,6 +433,15 @@ void Shared_MRW_Parameters::print_help_info() {
     		<< endl;
     cerr << "\t-adjust_online: adjusts restart frequency over time" << endl;
     cerr << "\t-num_threads n : sets number of mrw threads to run to n" << endl;
+    cerr << "\t-walk_threads n : each mrw thread runs the walks of a step " <<
+        "on n threads.\n\t\t" << DEFAULT_WALK_THREADS << " by default" << endl;
+    cerr << "\t-workers n : runs the steps of the mrw threads on n threads, " <<
+        "which take\n\t\tover each other's work when they are idle. 0 uses " <<
+        "all cores,\n\t\tby default there is one per mrw thread" << endl;
+    cerr << "\t-shared_q n : MDA and MHA walks start each step from the " <<
+        "action values\n\t\tlearned by all walkers, weighted as n " <<
+        "selections of each\n\t\toperator. 0 (the default) keeps them " <<
+        "to each walker" << endl;
     cerr << "\t-mrw_time_limit i : sets time limit for MRW to i seconds"
     		<< "\n\t\tn in {-1}U[1, infty). -1 means no limit (is default value)"
     		<< endl;
@@ -370,7 +471,9 @@ bool Shared_MRW_Parameters::check_for_conflicts() {
 		}
 	}
 
-	if(mrw_time_limit >= 0 && num_threads > 1) {
+	if(mrw_time_limit >= 0 &&
+			(num_threads > 1 || walk_threads > 1 || num_workers > 1 ||
+			 num_workers == 0)) {
 		cerr << "Time limits for mrw not currently enabled when using more than one thread" << endl;
 		return false;
 	}
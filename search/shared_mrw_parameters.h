@@ -27,11 +27,16 @@ protected:
 public:
     // types of restarts
 	enum {BASIC = 0, S_RESTART = 1};
+    // what the parameter learner rewards a configuration for: the progress
+    // of an episode, or the progress per CPU second or per evaluated walk
+    // endpoint of the configuration
+	enum {PROGRESS_REWARD = 0, TIME_REWARD = 1, EVAL_REWARD = 2};
     
     int restart_type;
     int pool_size;
     int act_level;
     float ucb_const;
+    int ucb_reward;
     bool run_aras;
     bool reg_aras;
     bool fast_aras;
@@ -40,7 +45,15 @@ public:
 
     int mrw_time_limit;
 
+    // number of MRW engines
     int num_threads;
+    // threads that each MRW thread runs the walks of a step on
+    int walk_threads;
+    // threads that run the steps of the MRW engines
+    int num_workers;
+    // weight, in selections, of the action values of all threads that the
+    // MDA and MHA walks of a step start from. 0 if they are not shared
+    int shared_q_weight;
 
     bool dovetail;
     bool adjust_online;
@@ -2,154 +2,203 @@
 #include "globals.h"
 #include <assert.h>
 
-Walk::Walk(vector<Node>& p, int end, float _h_ratio){
+Walk::Walk(const Trajectory& p, int end, float _h_ratio, int _bound){
 	assert(end <= p.size());
-	for (int i = 0; i < end; ++i) {
-		trajectory.push_back(p[i]);
+	trajectory.assign_prefix(p, end);
+
+	min_h_ratio.resize(trajectory.size());
+	for (int i = 0; i < trajectory.size(); ++i) {
+		min_h_ratio[i] = trajectory.get_h_ratio(i);
+		if(i > 0 && min_h_ratio[i - 1] < min_h_ratio[i])
+			min_h_ratio[i] = min_h_ratio[i - 1];
 	}
 
     h_ratio = _h_ratio;
+    bound = _bound;
 }
 
-Walk::Walk(vector<Node>& _t, float _h_ratio){
-	trajectory = _t;
-    h_ratio = _h_ratio;
+int Walk::get_num_nodes(int cost_bound) const{
+	if(cost_bound == -1)
+		return trajectory.size();
+	// costs never decrease along a trajectory
+	int low = 0, high = trajectory.size();
+	while(low < high) {
+		int mid = (low + high) / 2;
+		if(trajectory.get_cost(mid) > cost_bound)
+			high = mid;
+		else
+			low = mid + 1;
+	}
+	assert(low != 0);
+	return low;
 }
 
-void Walk::prune(int cost_bound){
-	assert(trajectory.size() > 0);
-	// cout << " " << trajectory.size();
-	for (int i = 0; i < trajectory.size(); ++i) {
-		if(trajectory[i].get_cost() > cost_bound){
-			//cout << trajectory[i].get_cost() << " " << cost_bound << endl;
-			assert(i != 0);
-			trajectory.erase(trajectory.begin() + i, trajectory.end());
-			break;
-		}
-	}
-	h_ratio = trajectory[0].get_h_ratio();
-	for (int i = 0; i < trajectory.size(); ++i) {
-		if(trajectory[i].get_h_ratio() < h_ratio){
-			h_ratio = trajectory[i].get_h_ratio();
-		}
-	}
-	//cout << "new_h after prunning ..." << endl;
+float Walk::get_h_ratio(int cost_bound) const{
+	if(cost_bound == bound)
+		return h_ratio;
+	return min_h_ratio[get_num_nodes(cost_bound) - 1];
 }
 
-void Walk::get_random_subseq(vector<Node>& t, MTRand_int32 *rand_gen,
-		const string &thread_name){
-	int index = rand_gen->get_32bit_int() % trajectory.size();
-	t.insert(t.end(), trajectory.begin(), trajectory.begin() + index + 1);
+void Walk::get_random_subseq(Trajectory& t, RandomStream *rand_gen,
+		int cost_bound, const string &thread_name) const{
+	int index = rand_gen->get_bounded(get_num_nodes(cost_bound));
+	t.assign_prefix(trajectory, index + 1);
 
 	cout << thread_name << "Starting with action index " << index <<
-			" with h_ratio value  " << h_ratio << endl;
+			" with h_ratio value  " << get_h_ratio(cost_bound) << endl;
 }
 
-/*State Walk::get_random_point(Path& p){
-	int index = random() % trajectory.size();
-	for (int i = 0; i < index; ++i) {
-		p.push_back(path[i]);
-	}
-	cout << "starting with " << index << " action of value: " << h << endl;
-	return trajectory[index];
-}*/
+WalkPool::WalkPool(int p, int n, int max_readers) {
+	max_size = p; 
+	walks = new Walk *[max_size];
+	for (int i = 0; i < max_size; ++i)
+		walks[i] = 0;
+	num_walks = 0;
+	count = 0;
+
+	activation_level = n;
+	bound = -1;
+	Trajectory t;
+	t.reset(*g_initial_state);
+	empty_walk = new Walk(t, 1, 1.0, bound);
 
-int Walk::get_cost(){
-	return trajectory.back().get_cost();
+	epoch = 1;
+	readers.resize(max_readers);
+	num_readers = 0;
 }
 
+WalkPool::~WalkPool() {
+	for (int i = 0; i < num_walks; ++i)
+		delete walks[i];
+	delete[] walks;
+	for (int i = 0; i < num_readers; ++i)
+		for (int j = 0; j < readers[i].retired.size(); ++j)
+			delete readers[i].retired[j].second;
+	delete empty_walk;
+}
 
-float Walk::get_h_ratio(){
-	return h_ratio;
+int WalkPool::register_reader() {
+	int reader = __sync_fetch_and_add(&num_readers, 1);
+	assert(reader < readers.size());
+	return reader;
 }
 
-WalkPool::WalkPool(int p, int n, MTRand_int32 *r) : rand_gen(r) {
-	max_size = p; 
-	count = 0;
-	max_index = UNKNOWN;
-    h_ratio_max = -1;
+void WalkPool::enter(int reader) {
+	readers[reader].active_epoch = epoch;
+	// the walks must only be read after the announcement is visible
+	__sync_synchronize();
+}
 
-	activation_level = n;
-	vector<Node> t;
-	t.push_back(Node(*g_initial_state, 0, 1, 0));
-	empty_walk = new Walk(t, 1.0);
-	bound = -1;
+void WalkPool::leave(int reader) {
+	__sync_synchronize();
+	readers[reader].active_epoch = 0;
 }
 
-void WalkPool::add_walk(vector<Node>& p, int end, float h_ratio,
-		const string &thread_name){
-	assert(p.size() > 0);
-	count++;
-	cout << thread_name << "h_ratio: " << h_ratio << endl;
-	/*if(pool.size() >= 1)
-		cout << "pool[0].size(): " << pool[0]->size() << endl;
-	cout << count << endl;*/
-	//cout << "path.size(): " << p.size() << endl;
-	if(h_ratio > h_ratio_max && pool.size() == max_size)
-		return;
+void WalkPool::retire(int reader, Walk *walk) {
+	// Threads that can still read the walk announced an epoch up to the
+	// current one before it was replaced, later ones cannot find it.
+	unsigned int retired_in = __sync_fetch_and_add(&epoch, 1);
+	readers[reader].retired.push_back(make_pair(retired_in, walk));
+	free_retired(reader);
+}
+
+void WalkPool::free_retired(int reader) {
+	unsigned int oldest = 0;
+	for (int i = 0; i < num_readers; ++i) {
+		unsigned int active = readers[i].active_epoch;
+		if(active != 0 && (oldest == 0 || active < oldest))
+			oldest = active;
+	}
 
-	if(pool.size() < max_size){
-		pool.push_back(new Walk(p, end, h_ratio));
-		
-        if(h_ratio > h_ratio_max){
-			h_ratio_max = h_ratio;
-			max_index = pool.size() - 1;
+	vector<pair<unsigned int, Walk *> > &retired = readers[reader].retired;
+	for (int i = 0; i < retired.size(); ) {
+		if(oldest == 0 || retired[i].first < oldest) {
+			delete retired[i].second;
+			retired[i] = retired.back();
+			retired.pop_back();
+		} else {
+			++i;
 		}
-	} else if(h_ratio < h_ratio_max){
-		delete pool[max_index];	
-		pool[max_index] = new Walk(p, end, h_ratio);
-		update_max();
 	}
-	cout << thread_name << "current pool size: " <<  pool.size() << endl;
-	// cout << "pool[0].size(): " << pool[0]->size() << endl;
 }
 
-void WalkPool::prune(int cost_bound){
-	if(cost_bound == -1 || cost_bound == bound)
-		return;
-	//TODO: current version of smart_restarts does not support f_prunning
-	for (int i = 0; i < pool.size(); ++i) {
-		// cout << "prunning " << i << endl;
-		pool[i]->prune(cost_bound);
-	}
-	/*cout << endl;
-	update_max();
-	for (int j = 0; j < pool.size(); ++j) {
-		cout << " " << j << ": " << pool[j]->get_cost() << ", h_ratio: " << pool[j]->get_h_ratio();
+int WalkPool::get_worst_walk() const{
+	int current_bound = bound;
+	int worst = -1;
+	float worst_h_ratio = 0;
+	for (int i = 0; i < max_size; ++i) {
+		float h = walks[i]->get_h_ratio(current_bound);
+		if(worst == -1 || h > worst_h_ratio){
+			worst = i;
+			worst_h_ratio = h;
+		}
 	}
-	cout << endl;*/
-	bound = cost_bound;
+	return worst;
 }
 
-void WalkPool::clear(){
-	cout << "clearing pool " << endl;
-	count = 0;
-	max_index = UNKNOWN;
-	h_ratio_max = -1;
-	vector<Node> t;
-	t.push_back(Node(*g_initial_state, 0, 1, 0));
-	empty_walk = new Walk(t, 1.0);
-	pool.clear();
-}
+void WalkPool::add_walk(int reader, const Trajectory& p, int end,
+		float h_ratio, const string &thread_name){
+	assert(p.size() > 0);
+	__sync_fetch_and_add(&count, 1);
+	cout << thread_name << "h_ratio: " << h_ratio << endl;
+
+	Walk *walk = new Walk(p, end, h_ratio, bound);
+	Walk *replaced = 0;
+	bool added = false;
+	enter(reader);
+	while(true) {
+		// fill the first empty entry while the pool is not full. Whoever
+		// sees the entry filled counts it, so the filled entries stay a
+		// prefix of the array without waiting for the thread that filled it.
+		int size = num_walks;
+		if(size < max_size) {
+			added = __sync_bool_compare_and_swap(&walks[size], (Walk *) 0,
+					walk);
+			__sync_bool_compare_and_swap(&num_walks, size, size + 1);
+			if(added)
+				break;
+			continue;
+		}
 
-void WalkPool::update_max(){
-	h_ratio_max = -1;
-	max_index = UNKNOWN;
-	for (int i = 0; i < pool.size(); ++i) {
-		if(pool[i]->h_ratio > h_ratio_max){
-			h_ratio_max = pool[i]->h_ratio;
-			max_index = i;
+		int worst = get_worst_walk();
+		Walk *old = walks[worst];
+		if(h_ratio >= old->get_h_ratio(bound))
+			break;
+		if(__sync_bool_compare_and_swap(&walks[worst], old, walk)) {
+			replaced = old;
+			added = true;
+			break;
 		}
 	}
+	int size = num_walks;
+	leave(reader);
+
+	if(replaced != 0)
+		retire(reader, replaced);
+	if(!added)
+		delete walk;
+	cout << thread_name << "current pool size: " <<  size << endl;
 }
 
-Walk* WalkPool::get_random_walk(){
-	if(count < activation_level || pool.size() == 0)
-		return empty_walk;
-	assert(pool.size() != 0);
-	int index = rand_gen->get_32bit_int() % pool.size();
-	return pool[index];
+void WalkPool::prune(int cost_bound){
+	if(cost_bound == -1)
+		return;
+	while(true) {
+		int old = bound;
+		if(old != -1 && old <= cost_bound)
+			return;
+		if(__sync_bool_compare_and_swap(&bound, old, cost_bound))
+			return;
+	}
 }
 
-	
-
+void WalkPool::get_random_subseq(int reader, Trajectory& t,
+		RandomStream *rand_gen, const string &thread_name){
+	enter(reader);
+	const Walk *walk = empty_walk;
+	int size = num_walks;
+	if(count >= activation_level && size > 0)
+		walk = walks[rand_gen->get_bounded(size)];
+	walk->get_random_subseq(t, rand_gen, bound, thread_name);
+	leave(reader);
+}
@@ -3,53 +3,102 @@
 
 
 #include "state.h"
+#include <string>
+#include <utility>
 #include <vector>
-#include "mrw.h"
-#include "mtrand.h"
+#include "random_stream.h"
+#include "trajectory.h"
 
 using namespace std;
 
-typedef vector<const Operator*> Path;
-class Node;
-
-
+/**
+ * A trajectory in the pool of smart restarts. Walks are never changed once
+ * they are in the pool; a lower cost bound only shortens the part of them
+ * that restarts start from.
+**/
 class Walk{
-	vector<Node> trajectory;
+	Trajectory trajectory;
+	// min_h_ratio[i] is the smallest h_ratio of the first i + 1 nodes
+	vector<float> min_h_ratio;
+	float h_ratio;
+	// cost bound of the pool when the walk was added
+	int bound;
 public:
-    float h_ratio;
+	Walk(const Trajectory& t, int end, float _h_ratio, int _bound);
 
-	Walk(vector<Node>& t, int end, float _h_ratio);
-	Walk(vector<Node>& _t, float _h_ratio);
-	void get_random_subseq(vector<Node>& t, MTRand_int32 *rand_gen,
-			const string &thread_name);
-	//State get_random_point(Path& p);
-	int get_cost();
-	void prune(int cost_bound);
-    float get_h_ratio();
-    int size(){return trajectory.size();}
+	// number of nodes of the walk whose cost is within cost_bound
+	int get_num_nodes(int cost_bound) const;
+	// the h_ratio of the walk under cost_bound. Once the bound has changed
+	// since the walk was added, this is the smallest h_ratio of the nodes
+	// within it.
+	float get_h_ratio(int cost_bound) const;
+	void get_random_subseq(Trajectory& t, RandomStream *rand_gen,
+			int cost_bound, const string &thread_name) const;
+	int size() const {return trajectory.size();}
 };
 
 
+/**
+ * The pool of walks that smart restarts start from, shared by all MRW
+ * threads without locks.
+ *
+ * The pool is an array of walk pointers. While it is not full, a walk is
+ * added into the first empty entry, so the filled entries are always a
+ * prefix of the array. Once it is full, a walk replaces the worst one by
+ * h_ratio with a compare-and-swap, and the adding thread retries if another
+ * thread changed that entry first.
+ *
+ * Replaced walks may still be read by other threads, so they are freed by
+ * epoch based reclamation: a thread announces the epoch it read while it is
+ * inside the pool, and a walk retired in epoch e is freed once no thread has
+ * announced an epoch up to e. Each thread registers once and passes its
+ * reader id to the pool.
+**/
 class WalkPool{
-	vector<Walk*> pool;
-	Walk* empty_walk;
+	struct Reader {
+		// 0 while the thread is outside the pool
+		volatile unsigned int active_epoch;
+		// walks that this thread replaced, with the epoch of the replacement
+		vector<pair<unsigned int, Walk *> > retired;
+		// keeps the announcements of different threads on different
+		// cache lines
+		char padding[64];
+
+		Reader() : active_epoch(0) {}
+	};
+
+	Walk * volatile *walks;
 	int max_size;
-	int count;
-	int max_index;
-    float h_ratio_max;
+	volatile int num_walks;
+	volatile int count;
 	int activation_level;
-	int bound;
-    MTRand_int32 *rand_gen;
+	// -1 if there is none
+	volatile int bound;
+	Walk* empty_walk;
+
+	volatile unsigned int epoch;
+	vector<Reader> readers;
+	volatile int num_readers;
 
-	enum {UNKNOWN = -1};
+	void enter(int reader);
+	void leave(int reader);
+	void retire(int reader, Walk *walk);
+	void free_retired(int reader);
+	// entry of the walk that a new walk should replace
+	int get_worst_walk() const;
 public:
-	
-	WalkPool(int p, int n, MTRand_int32 *r);
-	void add_walk(vector<Node>& p, int end, float h_ratio,
+
+	WalkPool(int p, int n, int max_readers);
+	~WalkPool();
+
+	// returns the id the calling thread passes to the pool from now on
+	int register_reader();
+	void add_walk(int reader, const Trajectory& p, int end, float h_ratio,
+			const string &thread_name);
+	// replaces t by the start of a random walk of the pool
+	void get_random_subseq(int reader, Trajectory& t, RandomStream *rand_gen,
 			const string &thread_name);
-	void update_max();
-	Walk* get_random_walk();
-	void clear();
+	// lowers the cost bound of the walks to solution_bound
 	void prune(int solution_bound);
 };
 
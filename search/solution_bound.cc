@@ -0,0 +1,14 @@
+#include "solution_bound.h"
+
+bool SolutionBound::improve(int plan_cost) {
+    while(true) {
+        int old_cost = cost;
+        if(old_cost != -1 && plan_cost >= old_cost)
+            return false;
+        if(__sync_bool_compare_and_swap(&cost, old_cost, plan_cost))
+            break;
+    }
+    // the new cost is visible before the epoch that announces it
+    __sync_fetch_and_add(&epoch, 1);
+    return true;
+}
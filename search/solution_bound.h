@@ -0,0 +1,36 @@
+#ifndef SOLUTION_BOUND_H
+#define SOLUTION_BOUND_H
+
+/**
+ * The cost of the best plan that any thread has found so far, which all
+ * engines prune against.
+ *
+ * Plans are saved one at a time under mutex_save_plan, but the engines read
+ * the bound in their inner loops and do so without a lock. The epoch is
+ * increased after every improvement, so an engine that keeps a bound of its
+ * own sees with a single comparison whether it has to update it.
+ *
+ * Without -iterative the first plan also cancels the search. The engines
+ * poll the flag between steps and stop.
+**/
+class SolutionBound {
+    volatile int cost;
+    volatile int epoch;
+    volatile bool cancelled;
+
+public:
+    SolutionBound() : cost(-1), epoch(0), cancelled(false) {}
+
+    // -1 as long as no plan has been found
+    int get_cost() const {return cost;}
+    int get_epoch() const {return epoch;}
+
+    // lowers the bound to the cost of a new plan, returns false if the
+    // bound was already as low
+    bool improve(int plan_cost);
+
+    void cancel() {cancelled = true;}
+    bool is_cancelled() const {return cancelled;}
+};
+
+#endif
@@ -32,8 +32,6 @@
 
 #include <algorithm>
 #include <iostream>
-#define S_HASH_SET_ENTRY_OVERHEAD 15
-#define S_HASH_SET_LOAD_FACTOR 2
 #define S_MAP_ENTRY_OVERHEAD 15
 #define S_MAP_LOAD_FACTOR 2
 
@@ -43,7 +41,7 @@ State::State(istream &in) {
 	check_magic(in, "begin_state");
 	for (int i = 0; i < g_variable_domain.size(); i++) {
 		int var;
-		cin >> var;
+		in >> var;
 		vars.push_back(var);
 	}
 	check_magic(in, "end_state");
@@ -53,8 +51,6 @@ State::State(istream &in) {
 	depth = 0;
 	reached_lms_cost = 0;
 	
-	reached_lms.clear();
-	
 	search_num = -1;
 	
 	state_is_dead_end = false;
@@ -69,45 +65,32 @@ void State::update_reached_lms(const Operator &op) {
 		const PrePost &pre_post = op.get_pre_post()[j];
 		// Test whether this effect got applied (it may have been conditional)
 		if ((*this)[pre_post.var] == pre_post.post) {
-			const LandmarkNode* node_p = g_lgraph->landmark_reached(make_pair(pre_post.var, pre_post.post));
-			if (node_p != 0) {
-				if (reached_lms.find(node_p) == reached_lms.end()) {
-					//cout << endl << "New LM reached! +++++++ ";
-					//g_lgraph->dump_node(node_p);
-					// Only add leaves of landmark graph to reached
-					const LandmarkNode& node = *node_p;
-					if (landmark_is_leaf(node, reached_lms)) {
-						//cout << "inserting new LM into reached. (1)" << endl; 
-						reached_lms.insert(node_p);
-						reached_lms_cost += node_p->min_cost;
-					}
-					//else
-					//cout << "not inserting into reached, has parents" << endl;
-				}
-			}
+			int id = g_lgraph->get_landmark_id(pre_post.var, pre_post.post);
+			// Only add leaves of landmark graph to reached
+			if (id != -1 && !reached_lms.test(id) &&
+					g_lgraph->parents_reached(id, reached_lms))
+				mark_landmark_reached(id);
 		}
 	}
-	const set<LandmarkNode*>& nodes = g_lgraph->get_nodes();
-	set<LandmarkNode*>::const_iterator it = nodes.begin();
-	for (; it != nodes.end(); ++it) {
-		const LandmarkNode* node = *it;
-		for (int i = 0; i < node->vars.size(); i++) {
-			if ((*this)[node->vars[i]] == node->vals[i]) {
-				if (reached_lms.find(node) == reached_lms.end()) {
-					//cout << "New LM reached by axioms: "; g_lgraph->dump_node(node);
-					if (landmark_is_leaf(*node, reached_lms)) {
-						//cout << "inserting new LM into reached. (2)" << endl; 
-						reached_lms.insert(node);
-						reached_lms_cost += node->min_cost;
-					}
-					//else
-					//cout << "not inserting into reached, has parents" << endl;
-				}
-			}
+	// Landmarks may also have been reached by axioms
+	int num_lms = g_lgraph->number_of_landmarks();
+	for (int id = 0; id < num_lms; id++) {
+		if (reached_lms.get_word(id / LandmarkBitset::WORD_BITS) == ~0U) {
+			id = (id / LandmarkBitset::WORD_BITS + 1) * LandmarkBitset::WORD_BITS - 1;
+			continue;
 		}
+		if (!reached_lms.test(id) &&
+				g_lgraph->get_landmark(id).is_true_in_state(*this) &&
+				g_lgraph->parents_reached(id, reached_lms))
+			mark_landmark_reached(id);
 	}
 }
 
+void State::mark_landmark_reached(int id) {
+	reached_lms.set(id);
+	reached_lms_cost += g_lgraph->get_landmark(id).min_cost;
+}
+
 void State::change_ancestor(const State &new_predecessor, const Operator &new_op) {
 	reached_lms = new_predecessor.reached_lms; // Can this be a problem?
 	reached_lms_cost = new_predecessor.reached_lms_cost;
@@ -152,115 +135,74 @@ void State::dump() const {
 	cout << "  " << g_variable_name[i] << ": " << vars[i] << endl;
 }
 
+StateHash State::get_hash() const {
+	StateHash hash;
+	for (int i = 0; i < vars.size(); i++)
+		hash.toggle(i, vars[i]);
+	return hash;
+}
+
+unsigned int State::get_reached_lms_hash() const {
+	unsigned int hash = 0;
+	for (int i = 0; i < reached_lms.get_num_words(); i++)
+		hash = mix_hash_bits(hash ^ reached_lms.get_word(i));
+	return hash;
+}
+
 bool State::operator<(const State &other) const {
 	return lexicographical_compare(vars.begin(), vars.end(),
 			other.vars.begin(), other.vars.end());
 }
 
 void State::set_landmarks_for_initial_state() {
-	hash_set<const LandmarkNode*, hash_pointer> initial_state_landmarks;
+	reached_lms_cost = 0;
 	if (g_lgraph == NULL) {
 		// landmarks not used, set empty
-		reached_lms = initial_state_landmarks;
+		reached_lms.reset(0);
 		return;
 	}
+	reached_lms.reset(g_lgraph->number_of_landmarks());
 	for (int i = 0; i < g_variable_domain.size(); i++) {
 		const pair<int, int> a = make_pair(i, (*g_initial_state)[i]);
 		if (g_lgraph->simple_landmark_exists(a)) {
 			LandmarkNode& node = g_lgraph->get_simple_lm_node(a);
-			if (node.parents.size() == 0) {
-				initial_state_landmarks.insert(&node);
-				reached_lms_cost += node.min_cost;
-			}
+			if (node.parents.size() == 0 && !reached_lms.test(node.id))
+				mark_landmark_reached(node.id);
 		} else {
 			set<pair<int, int> > a_set;
 			a_set.insert(a);
 			if (g_lgraph->disj_landmark_exists(a_set)) {
 				LandmarkNode& node = g_lgraph->get_disj_lm_node(a);
-				if (node.parents.size() == 0) {
-					initial_state_landmarks.insert(&node);
-					reached_lms_cost += node.min_cost;
-				}
+				if (node.parents.size() == 0 && !reached_lms.test(node.id))
+					mark_landmark_reached(node.id);
 			}
 		}
 	}
-	cout << initial_state_landmarks.size() << " initial landmarks, " << g_goal.size() << " goal landmarks" << endl;
-	reached_lms = initial_state_landmarks;
+	cout << reached_lms.count() << " initial landmarks, " << g_goal.size() << " goal landmarks" << endl;
 }
 
-bool State::landmark_is_leaf(const LandmarkNode& node, const hash_set<const LandmarkNode*, hash_pointer>& reached) const {
-	//Note: this is the same as !check_node_orders_disobeyed
-	const hash_map<LandmarkNode*, edge_type, hash_pointer>& parents = node.parents;
-	/*
-	 cout << "in is_leaf, reached is ----- " << endl;
-	 hash_set<const LandmarkNode*, hash_pointer>::const_iterator it;
-	 for(it = reached.begin(); it != reached.end(); ++it) {
-	 cout << *it << " ";
-	 lgraph.dump_node(*it);
-	 }
-	 cout << "---------" << endl;
-	 */
-	for (hash_map<LandmarkNode*, edge_type, hash_pointer>::const_iterator parent_it = parents.begin(); parent_it
-			!= parents.end(); parent_it++) {
-		LandmarkNode* parent_p = parent_it->first;
-
-		if (true) // Note: no condition on edge type here
-
-			if (reached.find(parent_p) == reached.end()) {
-
-				//cout << "parent is not in reached: "; 
-				//cout << parent_p << " ";
-				//lgraph.dump_node(parent_p);
-				return false;
-			}
-	}
-	//cout << "all parents are in reached" << endl;
-	return true;
-}
-
-bool State::check_lost_landmark_children_needed_again(const LandmarkNode& node) const {
-	const hash_set<const LandmarkNode*, hash_pointer>& reached = this->reached_lms;
-	const hash_map<LandmarkNode*, edge_type, hash_pointer>& children = node.children;
-
-	for (hash_map<LandmarkNode*, edge_type, hash_pointer>::const_iterator child_it = children.begin(); child_it
-			!= children.end(); child_it++) {
-		LandmarkNode* child_p = child_it->first;
-		if (child_it->second == gn) // Note: condition on edge type here!
-			if (reached.find(child_p) == reached.end()) {
-				return true;
-			}
-	}
-	return false;
-}
-
-int State::get_needed_landmarks(hash_set<const LandmarkNode*, hash_pointer>& needed) const {
-	// Calculate landmarks that will be needed again and their cost
-	const hash_set<const LandmarkNode*, hash_pointer>& reached = this->reached_lms;
+int State::get_needed_landmarks(int &num_needed) const {
+	// Calculate landmarks that will be needed again and their cost. These are
+	// reached landmarks that are false now and either are goals or have a
+	// greedy-necessary child that has not been reached.
+	num_needed = 0;
 	int needed_lm_cost = 0;
-	for (hash_set<const LandmarkNode*, hash_pointer>::const_iterator it = reached.begin(); it != reached.end(); it++)
-		if (!(*it)->is_true_in_state(*this)) {
-			if ((*it)->is_goal()) {
-				needed.insert(*it);
-				needed_lm_cost += (*it)->min_cost;
-			} else {
-				const LandmarkNode& node = **it;
-				if (check_lost_landmark_children_needed_again(node)) {
-					needed.insert(&node);
-					needed_lm_cost += node.min_cost;
-					//cout << "needed again is "; g_lgraph->dump_node(&node);
-				}
+	for (int i = 0; i < reached_lms.get_num_words(); i++) {
+		unsigned int word = reached_lms.get_word(i);
+		while (word != 0) {
+			int id = i * LandmarkBitset::WORD_BITS + __builtin_ctz(word);
+			word &= word - 1;
+			const LandmarkNode &node = g_lgraph->get_landmark(id);
+			if (!node.is_true_in_state(*this) &&
+					(node.is_goal() || !g_lgraph->gn_children_reached(id, reached_lms))) {
+				num_needed++;
+				needed_lm_cost += node.min_cost;
 			}
 		}
+	}
 	return needed_lm_cost;
 }
 
-int State::check_partial_plan(hash_set<const LandmarkNode*, hash_pointer>& reached) const {
-	// Return reached landmarks and their cost
-	reached = reached_lms;
-	return reached_lms_cost;
-}
-
-
 void State::add_heuristic_value(std::string h_name, int h) {
     h_values[h_name] = h;
 }
@@ -299,9 +241,8 @@ bool State::get_preferred_ops(std::string heur_name, vector<const Operator *> &p
 size_t State::approx_num_bytes() const {
     size_t size = sizeof(State) /* State Size */ 
                 + vars.capacity()*sizeof(int) /* Vars Size */
-                /* reached lms size estimate */
-                + S_HASH_SET_LOAD_FACTOR*reached_lms.size()*(S_HASH_SET_ENTRY_OVERHEAD +
-                		sizeof(LandmarkNode *) + sizeof(hash_pointer)) +
+                /* reached lms size */
+                + reached_lms.get_num_words()*sizeof(unsigned int) +
                 /* h_values size estimate */
                 + S_MAP_LOAD_FACTOR*h_values.size()*(S_MAP_ENTRY_OVERHEAD +
                 		sizeof(std::string) + sizeof(int)) +
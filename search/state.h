@@ -29,6 +29,7 @@
 #include <vector>
 #include <ext/hash_set>
 #include "landmarks_types.h"
+#include "state_hash.h"
 #include <cassert>
 #include <map>
 #include <string>
@@ -45,8 +46,9 @@ class AxiomEvaluator;
 class State {
 	friend void read_everything(istream &in, bool generate_landmarks, 
             bool reasonable_orders);
+	friend class WalkState;
 	vector<int> vars; // values for vars
-	hash_set<const LandmarkNode *, hash_pointer> reached_lms;
+	LandmarkBitset reached_lms;
 	int reached_lms_cost;
 
 	int g_value; // min. cost of reaching this state from the initial state
@@ -54,8 +56,7 @@ class State {
 
 	void set_landmarks_for_initial_state();
 	void update_reached_lms(const Operator &op);
-	bool landmark_is_leaf(const LandmarkNode& node, const hash_set<const LandmarkNode*, hash_pointer>& reached) const;
-	bool check_lost_landmark_children_needed_again(const LandmarkNode& node) const;
+	void mark_landmark_reached(int id);
 	
 	int search_num;
     
@@ -85,6 +86,11 @@ public:
 	
 	bool operator<(const State &other) const;
 
+	// Zobrist fingerprint of the variable assignment
+	StateHash get_hash() const;
+	// order independent fingerprint of the set of reached landmarks
+	unsigned int get_reached_lms_hash() const;
+
 	int get_g_value() const { return g_value; }
 	int get_depth() const {return depth;}
 	
@@ -109,8 +115,11 @@ public:
 
 	void change_ancestor(const State &new_predecessor, const Operator &new_op);
 
-	int check_partial_plan(hash_set<const LandmarkNode*, hash_pointer>& reached) const;
-	int get_needed_landmarks(hash_set<const LandmarkNode*, hash_pointer>& needed) const;
+	// landmarks that have been true at some point and their cost
+	const LandmarkBitset &get_reached_lms() const {return reached_lms;}
+	int get_reached_lms_cost() const {return reached_lms_cost;}
+	// landmarks of reached_lms that are needed again, returns their cost
+	int get_needed_landmarks(int &num_needed) const;
 
     size_t approx_num_bytes() const;
     
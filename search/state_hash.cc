@@ -0,0 +1,25 @@
+#include "state_hash.h"
+
+#include "globals.h"
+#include "random_stream.h"
+
+// fixed seed so that fingerprints are the same in every run
+#define STATE_HASH_SEED 2654435761UL
+
+vector<int> g_state_hash_key_offset;
+vector<unsigned int> g_state_hash_keys;
+
+void init_state_hash_keys() {
+    RandomStream rand_gen(STATE_HASH_SEED, RandomStream::HASH_KEY_STREAM, 0);
+
+    g_state_hash_key_offset.resize(g_variable_domain.size());
+    int num_facts = 0;
+    for(int var = 0; var < g_variable_domain.size(); var++) {
+        g_state_hash_key_offset[var] = num_facts;
+        num_facts += g_variable_domain[var];
+    }
+
+    g_state_hash_keys.resize(2 * num_facts);
+    for(int i = 0; i < g_state_hash_keys.size(); i++)
+        g_state_hash_keys[i] = rand_gen.get_32bit_int();
+}
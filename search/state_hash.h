@@ -0,0 +1,64 @@
+#ifndef STATE_HASH_H
+#define STATE_HASH_H
+
+#include <vector>
+
+/**
+ * A Zobrist fingerprint of a state. It is kept as two 32-bit halves so that
+ * each half can be read and written atomically, also in 32-bit builds. The
+ * index half is used to address tables and the check half to verify that a
+ * table entry really belongs to the state.
+**/
+struct StateHash {
+    unsigned int index;
+    unsigned int check;
+
+    StateHash() : index(0), check(0) {}
+    StateHash(unsigned int i, unsigned int c) : index(i), check(c) {}
+
+    // flips the key of the fact var=val in or out of the fingerprint
+    inline void toggle(int var, int val);
+
+    // mixes an arbitrary value (heuristic id, landmark, ...) into the
+    // fingerprint
+    inline void mix(unsigned int value);
+
+    bool operator==(const StateHash &other) const {
+        return index == other.index && check == other.check;
+    }
+    bool operator!=(const StateHash &other) const {
+        return !(*this == other);
+    }
+};
+
+// builds the random keys of all facts. Must be called once the variables
+// have been read and before any fingerprint is computed.
+void init_state_hash_keys();
+
+// key of fact var=val is at g_state_hash_keys[2 * (offset[var] + val)]
+// (index half) and the position after that (check half)
+extern std::vector<int> g_state_hash_key_offset;
+extern std::vector<unsigned int> g_state_hash_keys;
+
+// Finalizer of MurmurHash3. A cheap bijective mix of 32 bits.
+inline unsigned int mix_hash_bits(unsigned int h) {
+    h ^= h >> 16;
+    h *= 0x85ebca6bU;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35U;
+    h ^= h >> 16;
+    return h;
+}
+
+inline void StateHash::toggle(int var, int val) {
+    int pos = 2 * (g_state_hash_key_offset[var] + val);
+    index ^= g_state_hash_keys[pos];
+    check ^= g_state_hash_keys[pos + 1];
+}
+
+inline void StateHash::mix(unsigned int value) {
+    index = mix_hash_bits(index ^ value);
+    check = mix_hash_bits(check + 0x9e3779b9U * (value + 1));
+}
+
+#endif
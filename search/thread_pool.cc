@@ -0,0 +1,107 @@
+#include "thread_pool.h"
+
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+
+ThreadPool::ThreadPool(int threads) {
+    num_threads = threads < 1 ? 1 : threads;
+    task = 0;
+    num_items = 0;
+    next_item = 0;
+    generation = 0;
+    num_busy = 0;
+    shutting_down = false;
+
+    pthread_mutex_init(&mutex, NULL);
+    pthread_cond_init(&work_available, NULL);
+    pthread_cond_init(&work_done, NULL);
+
+    workers.resize(num_threads - 1);
+    worker_data.resize(num_threads - 1);
+    for(int i = 0; i < workers.size(); i++) {
+        worker_data[i].pool = this;
+        worker_data[i].thread = i + 1;
+        int rc = pthread_create(&workers[i], NULL, worker_main,
+                (void *)&worker_data[i]);
+        if(rc) {
+            cerr << "ERROR: Return code from pthread_create is " << rc << endl;
+            exit(-1);
+        }
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    pthread_mutex_lock(&mutex);
+    shutting_down = true;
+    pthread_cond_broadcast(&work_available);
+    pthread_mutex_unlock(&mutex);
+
+    for(int i = 0; i < workers.size(); i++)
+        pthread_join(workers[i], NULL);
+
+    pthread_cond_destroy(&work_done);
+    pthread_cond_destroy(&work_available);
+    pthread_mutex_destroy(&mutex);
+}
+
+void *ThreadPool::worker_main(void *data) {
+    WorkerData *my_data = (WorkerData *)data;
+    ThreadPool *pool = my_data->pool;
+
+    int seen_generation = 0;
+    while(true) {
+        pthread_mutex_lock(&pool->mutex);
+        while(pool->generation == seen_generation && !pool->shutting_down)
+            pthread_cond_wait(&pool->work_available, &pool->mutex);
+        if(pool->shutting_down) {
+            pthread_mutex_unlock(&pool->mutex);
+            return NULL;
+        }
+        seen_generation = pool->generation;
+        pthread_mutex_unlock(&pool->mutex);
+
+        pool->work(my_data->thread);
+
+        pthread_mutex_lock(&pool->mutex);
+        pool->num_busy--;
+        if(pool->num_busy == 0)
+            pthread_cond_signal(&pool->work_done);
+        pthread_mutex_unlock(&pool->mutex);
+    }
+}
+
+void ThreadPool::work(int thread) {
+    while(true) {
+        int item = __sync_fetch_and_add(&next_item, 1);
+        if(item >= num_items)
+            return;
+        task->run(item, thread);
+    }
+}
+
+void ThreadPool::run(ParallelTask &t, int items) {
+    if(num_threads == 1) {
+        for(int i = 0; i < items; i++)
+            t.run(i, 0);
+        return;
+    }
+
+    pthread_mutex_lock(&mutex);
+    task = &t;
+    num_items = items;
+    next_item = 0;
+    num_busy = num_threads - 1;
+    generation++;
+    pthread_cond_broadcast(&work_available);
+    pthread_mutex_unlock(&mutex);
+
+    work(0);
+
+    pthread_mutex_lock(&mutex);
+    while(num_busy > 0)
+        pthread_cond_wait(&work_done, &mutex);
+    task = 0;
+    pthread_mutex_unlock(&mutex);
+}
@@ -0,0 +1,59 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <pthread.h>
+#include <vector>
+
+/**
+ * Work that can be split into independent items. run is called once for
+ * every item, possibly concurrently from different threads. thread is the
+ * index of the calling thread in the pool, so tasks can keep scratch space
+ * per thread.
+**/
+class ParallelTask {
+public:
+    virtual ~ParallelTask() {}
+    virtual void run(int item, int thread) = 0;
+};
+
+/**
+ * A fixed set of threads that execute ParallelTasks. The thread calling run
+ * takes part in the work as thread 0 and run only returns once all items are
+ * done, so a pool with a single thread simply runs the items in order.
+ *
+ * Only one task can run at a time and run must not be called by the tasks
+ * themselves.
+**/
+class ThreadPool {
+    int num_threads;
+    std::vector<pthread_t> workers;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t work_available;
+    pthread_cond_t work_done;
+
+    ParallelTask *task;
+    int num_items;
+    volatile int next_item;
+    int generation;
+    int num_busy;
+    bool shutting_down;
+
+    struct WorkerData {
+        ThreadPool *pool;
+        int thread;
+    };
+    std::vector<WorkerData> worker_data;
+
+    static void *worker_main(void *data);
+    void work(int thread);
+
+public:
+    ThreadPool(int threads);
+    ~ThreadPool();
+
+    void run(ParallelTask &t, int items);
+    int get_num_threads() const {return num_threads;}
+};
+
+#endif
@@ -2,6 +2,7 @@
 
 #include <ostream>
 #include <sys/times.h>
+#include <time.h>
 #include <unistd.h>
 
 using namespace std;
@@ -58,3 +59,9 @@ ostream &operator<<(ostream &os, const Timer &timer) {
     os << value << "s";
     return os;
 }
+
+double get_thread_time() {
+    struct timespec the_time;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &the_time);
+    return the_time.tv_sec + the_time.tv_nsec / 1e9;
+}
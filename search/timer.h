@@ -20,4 +20,8 @@ public:
 
 std::ostream &operator<<(std::ostream &os, const Timer &timer);
 
+// CPU time used by the calling thread so far, in seconds. Timer measures the
+// whole process, which is shared by all search threads.
+double get_thread_time();
+
 #endif
@@ -0,0 +1,59 @@
+#include "trajectory.h"
+
+#include "operator.h"
+
+using namespace std;
+
+void Trajectory::reset(const State &state) {
+    ops.assign(1, static_cast<const Operator *>(0));
+    costs.assign(1, 0);
+    h_ratios.assign(1, 1.0);
+    checkpoints.clear();
+    checkpoints.push_back(state);
+}
+
+void Trajectory::push_back(const State &state, const Operator *op,
+                           float h_ratio, int cost) {
+    assert(size() > 0);
+    if(size() % CHECKPOINT_INTERVAL == 0)
+        checkpoints.push_back(state);
+    ops.push_back(op);
+    costs.push_back(cost);
+    h_ratios.push_back(h_ratio);
+}
+
+void Trajectory::truncate(int num_nodes) {
+    assert(num_nodes > 0 && num_nodes <= size());
+    ops.resize(num_nodes);
+    costs.resize(num_nodes);
+    h_ratios.resize(num_nodes);
+    int num_checkpoints = (num_nodes - 1) / CHECKPOINT_INTERVAL + 1;
+    checkpoints.erase(checkpoints.begin() + num_checkpoints, checkpoints.end());
+}
+
+void Trajectory::assign_prefix(const Trajectory &other, int num_nodes) {
+    assert(num_nodes > 0 && num_nodes <= other.size());
+    ops.assign(other.ops.begin(), other.ops.begin() + num_nodes);
+    costs.assign(other.costs.begin(), other.costs.begin() + num_nodes);
+    h_ratios.assign(other.h_ratios.begin(),
+                    other.h_ratios.begin() + num_nodes);
+    int num_checkpoints = (num_nodes - 1) / CHECKPOINT_INTERVAL + 1;
+    checkpoints.assign(other.checkpoints.begin(),
+                       other.checkpoints.begin() + num_checkpoints);
+}
+
+State Trajectory::get_state(int i, AxiomEvaluator *axiom_eval) const {
+    assert(i >= 0 && i < size());
+    int first = (i / CHECKPOINT_INTERVAL) * CHECKPOINT_INTERVAL;
+    State state = checkpoints[i / CHECKPOINT_INTERVAL];
+    for(int j = first + 1; j <= i; j++) {
+        assert(ops[j]->is_applicable(state));
+        state = State(state, *ops[j], axiom_eval);
+    }
+    return state;
+}
+
+void Trajectory::get_path(vector<const Operator *> &path) const {
+    for(int i = 1; i < size(); i++)
+        path.push_back(ops[i]);
+}
@@ -0,0 +1,51 @@
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include "state.h"
+
+#include <cassert>
+#include <vector>
+
+class AxiomEvaluator;
+class Operator;
+
+/**
+ * The sequence of states that an MRW search has jumped through, starting
+ * from a given state. A node is stored as the operator that leads to it, its
+ * cost and its h_ratio, and only every CHECKPOINT_INTERVAL-th node keeps its
+ * full state. The states of the other nodes are rebuilt from the checkpoint
+ * before them when they are needed.
+**/
+class Trajectory {
+    // operator leading to each node, 0 for the first one
+    std::vector<const Operator *> ops;
+    std::vector<int> costs;
+    std::vector<float> h_ratios;
+
+    // state of node i * CHECKPOINT_INTERVAL
+    std::vector<State> checkpoints;
+public:
+    enum {CHECKPOINT_INTERVAL = 32};
+
+    // makes state the only node, with cost 0 and h_ratio 1
+    void reset(const State &state);
+    // state is the result of applying op to the state of the last node
+    void push_back(const State &state, const Operator *op, float h_ratio,
+                   int cost);
+    // keeps the first num_nodes nodes
+    void truncate(int num_nodes);
+    void pop_back() {truncate(size() - 1);}
+    // makes this the first num_nodes nodes of other
+    void assign_prefix(const Trajectory &other, int num_nodes);
+
+    int size() const {return ops.size();}
+    const Operator *get_op(int i) const {return ops[i];}
+    int get_cost(int i) const {return costs[i];}
+    float get_h_ratio(int i) const {return h_ratios[i];}
+    State get_state(int i, AxiomEvaluator *axiom_eval) const;
+
+    // the operators leading from the first node to the last one
+    void get_path(std::vector<const Operator *> &path) const;
+};
+
+#endif
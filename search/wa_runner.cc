@@ -13,8 +13,10 @@
 #include "blind_search_heuristic.h"
 #include "landmarks_count_heuristic.h"
 #include "goal_count_heuristic.h"
+#include "cg_heuristic.h"
 #include "mrw.h"
 #include "mrw_runner.h"
+#include "mrw_scheduler.h"
 #include "memory_utils.h"
 
 // heuristics used for lama
@@ -24,11 +26,30 @@ FFHeuristic *lama_ff_heur = NULL;
 FDFFHeuristic *lama_fd_ff_heur = NULL;
 LAMA_FFC_Heuristic *lama_ffc_heur = NULL;
 LAMA_FFS_Heuristic *lama_ffs_heur = NULL;
+CGHeuristic *lama_cg_heur = NULL;
 
 // adds the heuristics to a best first search engine
 void add_heuristics(WA_Star_Parameters *wa_star_params, DelayedWAStar* engine,
 		AxiomEvaluator *axiom_eval);
 
+// the mrw engine that this thread runs if no other one is left when
+// wa* is done
+class FallbackEngineFactory : public EngineFactory {
+	const string &name;
+public:
+	FallbackEngineFactory(const string &n) : name(n) {}
+	virtual MRW *create_engine() {
+		// a thread index that none of the mrw threads had
+		int thread = g_mrw_shared->num_threads;
+
+		// should only get here if there is only one thread
+		if(g_mrw_shared->num_threads == 1) {
+			g_mrw_shared->mrw_time_limit = -1;
+		}
+		return ::create_engine(thread, create_learner(thread), name);
+	}
+};
+
 void run_wa_star(WA_Star_Parameters *wa_star_params, bool run_mrw_after) {
 
 	string name = "";
@@ -57,7 +78,7 @@ void run_wa_star(WA_Star_Parameters *wa_star_params, bool run_mrw_after) {
 	
 	int wastar_weight = -1;
 
-    MTRand_int32 rand_gen(get_current_seed(77));
+    RandomStream rand_gen(g_seed, RandomStream::WA_STAR_STREAM, 0);
 
     int current_node_limit = wa_star_params->init_node_limit;
     int count_out_of_memory = 0;
@@ -66,7 +87,7 @@ void run_wa_star(WA_Star_Parameters *wa_star_params, bool run_mrw_after) {
 	
 	do {
 		// if have already found a solution and not iterative, don't continue looking
-		if(!g_iterative && g_best_sol_cost >= 0)
+		if(g_solution_bound.is_cancelled())
 			break;
 
         wastar_weight = wa_star_params->weights[iteration_no % wa_star_params->weights.size()];
@@ -112,7 +133,15 @@ void run_wa_star(WA_Star_Parameters *wa_star_params, bool run_mrw_after) {
         	if(wa_star_params->bounding_type == WA_Star_Parameters::DAS &&
         			iteration_no % wa_star_params->weights.size() == 0)
         		current_bound = -1;
+        	// the best plan so far may have been found by another thread,
+        	// but DAS starts a pass through the weights without a bound
+        	int shared_bound = g_solution_bound.get_cost();
+        	if(wa_star_params->bounding_type == WA_Star_Parameters::WA &&
+        			shared_bound != -1 &&
+        			(current_bound == -1 || shared_bound < current_bound))
+        		current_bound = shared_bound;
         	engine->set_local_bound(current_bound);
+        	engine->set_follow_shared_bound();
         	cout << "Current Bound: " << current_bound << endl;
         }
 
@@ -178,18 +207,15 @@ void run_wa_star(WA_Star_Parameters *wa_star_params, bool run_mrw_after) {
 	while(wa_star_params->loop_weights || iteration_no < wa_star_params->weights.size());
 
 	// if should run mrw afterwards
-	if(run_mrw_after && (g_iterative || g_best_sol_cost == -1)) {
+	if(run_mrw_after && !g_solution_bound.is_cancelled()) {
 		assert(g_mrw_shared != NULL);
 
-		struct mrw_thread_data mrw_data;
-		mrw_data.seed = get_current_seed(1992);
-		mrw_data.name = name;
+		assert(g_mrw_scheduler != NULL);
 
-		// should only get here if there is only one thread
-		if(g_mrw_shared->num_threads == 1) {
-			g_mrw_shared->mrw_time_limit = -1;
-		}
-		run_mrw_thread((void *) &mrw_data);
+		// this thread helps the mrw engines that are still running, or
+		// else runs a new one
+		FallbackEngineFactory factory(name);
+		g_mrw_scheduler->work_or_run(factory);
 	}
 }
 
@@ -221,12 +247,13 @@ void add_heuristics(WA_Star_Parameters *wa_star_params, DelayedWAStar* engine,
 	
 	bool use_goal_count = wa_star_params->heuristics.count("GOAL_COUNT") != 0;
 
-	/** 
-    LM-count should always be added before lama_ff_heur if lm-count is using
-	preferred operators. This is because sometimes the value calculated during
-	the preferred operators segment can be cached and no new computation is
-	needed when querying lama_ff for a heuristic. This can greatly speed up
-	the search
+	bool use_cg = wa_star_params->heuristics.count("CG") != 0;
+	bool use_cg_prefs = wa_star_params->pref_op_heuristics.count("CG") != 0;
+
+	/**
+	All heuristics built on lama_ff_heur share its relaxed exploration and
+	relaxed plan for the state being evaluated, so the order in which they
+	are added does not matter.
 	**/
 	if(use_lm || use_lm_prefs) {
 		
@@ -240,10 +267,6 @@ void add_heuristics(WA_Star_Parameters *wa_star_params, DelayedWAStar* engine,
 		engine->add_heuristic(lama_lm_heur, use_lm, use_lm_prefs);
 	}
 
-    /**
-    Lama_FF should also be called before any of the other ones built on LAMA_FF
-    so that the values can simply be reused as necessary.
-    **/  
     if(use_ff || use_ff_prefs) {
         
         if(lama_ff_heur == NULL)
@@ -329,6 +352,14 @@ void add_heuristics(WA_Star_Parameters *wa_star_params, DelayedWAStar* engine,
 		engine->add_heuristic(lama_fd_ff_heur, use_fd_ff, use_fd_ff_prefs);
 	}
 	
+	if(use_cg || use_cg_prefs) {
+
+		if(lama_cg_heur == NULL)
+			lama_cg_heur = new CGHeuristic;
+
+		engine->add_heuristic(lama_cg_heur, use_cg, use_cg_prefs);
+	}
+
 	if(use_blind) {
 	    engine->add_heuristic(new BlindSearchHeuristic, true, false);
 	}
@@ -251,6 +251,7 @@ bool WA_Star_Parameters::parse_heuristic(string str_heur) {
        str_heur.compare("LM") != 0 &&
        str_heur.compare("BLIND") != 0 &&
        str_heur.compare("GOAL_COUNT") != 0 &&
+       str_heur.compare("CG") != 0 &&
        str_heur.compare("FF_SWITCH") != 0 &&
        str_heur.compare("FD_SWITCH") != 0) {
     
@@ -276,6 +277,7 @@ bool WA_Star_Parameters::parse_preferred(string str_pref) {
        str_pref.compare("LAMA_FF_C") != 0 &&
        str_pref.compare("FD_FF") != 0 &&
        str_pref.compare("LM") != 0 &&
+       str_pref.compare("CG") != 0 &&
        str_pref.compare("FF_SWITCH") != 0 &&
        str_pref.compare("FD_SWITCH") != 0) {
 
@@ -0,0 +1,89 @@
+#include "walk_state.h"
+
+#include "axioms.h"
+#include "globals.h"
+#include "operator.h"
+
+#include <cassert>
+
+using namespace std;
+
+WalkState::WalkState() : state(*g_initial_state), start(0),
+        track_landmarks(false) {
+    // the heuristic values stored in the initial state are not those of
+    // the states of the walk
+    state.h_values.clear();
+    state.pref_map.clear();
+    state.search_num = -1;
+    state.state_is_dead_end = false;
+
+    for(int var = 0; var < g_axiom_layers.size(); var++)
+        if(g_axiom_layers[var] != -1)
+            derived_vars.push_back(var);
+}
+
+void WalkState::rewind() {
+    for(int i = undo_log.size() - 1; i >= 0; i--)
+        state.vars[undo_log[i].first] = undo_log[i].second;
+    undo_log.clear();
+    hash = start_hash;
+}
+
+void WalkState::reset(const State &start_state) {
+    if(&start_state == start) {
+        rewind();
+    } else {
+        // assigning keeps the memory of the variables
+        state.vars = start_state.vars;
+        undo_log.clear();
+        start = &start_state;
+        start_hash = start_state.get_hash();
+        hash = start_hash;
+    }
+    assert(state.vars == start_state.vars);
+    assert(hash == start_state.get_hash());
+
+    if(track_landmarks) {
+        state.reached_lms = start_state.reached_lms;
+        state.reached_lms_cost = start_state.reached_lms_cost;
+    }
+}
+
+void WalkState::apply(const Operator &op, AxiomEvaluator *axiom_eval) {
+    assert(!op.is_axiom());
+    assert(op.is_applicable(state));
+
+    // the effect conditions refer to the state before the operator
+    const vector<PrePost> &pre_post = op.get_pre_post();
+    firing_effects.clear();
+    for(int i = 0; i < pre_post.size(); i++)
+        if(pre_post[i].does_fire(state))
+            firing_effects.push_back(i);
+    for(int i = 0; i < firing_effects.size(); i++) {
+        const PrePost &effect = pre_post[firing_effects[i]];
+        int &value = state.vars[effect.var];
+        if(value != effect.post) {
+            undo_log.push_back(make_pair(effect.var, value));
+            hash.toggle(effect.var, value);
+            hash.toggle(effect.var, effect.post);
+            value = effect.post;
+        }
+    }
+
+    if(!derived_vars.empty()) {
+        derived_values.clear();
+        for(int i = 0; i < derived_vars.size(); i++)
+            derived_values.push_back(state.vars[derived_vars[i]]);
+        axiom_eval->evaluate(state);
+        for(int i = 0; i < derived_vars.size(); i++)
+            if(state.vars[derived_vars[i]] != derived_values[i]) {
+                undo_log.push_back(make_pair(derived_vars[i],
+                                             derived_values[i]));
+                hash.toggle(derived_vars[i], derived_values[i]);
+                hash.toggle(derived_vars[i], state.vars[derived_vars[i]]);
+            }
+    }
+
+    if(track_landmarks)
+        state.update_reached_lms(op);
+}
@@ -0,0 +1,64 @@
+#ifndef WALK_STATE_H
+#define WALK_STATE_H
+
+#include "state.h"
+#include "state_hash.h"
+
+#include <utility>
+#include <vector>
+
+class AxiomEvaluator;
+class Operator;
+
+/**
+ * The state at the end of a random walk so far. Operators are applied to it
+ * in place and the values they overwrite go to an undo log, so a step does
+ * not copy the state and a walk from the same start as the one before is
+ * set up by undoing the steps of that walk.
+ *
+ * The fingerprint of the state is updated along with the variables, so the
+ * endpoint of a walk can be identified without hashing all of them.
+ *
+ * The heuristic values and preferred operators stored in a State are never
+ * set, and the reached landmarks are only kept up to date if the heuristic
+ * of the walk uses them.
+**/
+class WalkState {
+    State state;
+    // start of the last walk, 0 if it may no longer exist
+    const State *start;
+    bool track_landmarks;
+
+    StateHash hash;
+    StateHash start_hash;
+
+    // (variable, previous value) for every change since the start
+    std::vector<std::pair<int, int> > undo_log;
+
+    std::vector<int> derived_vars;
+    // buffers of apply, kept between steps
+    std::vector<int> firing_effects;
+    std::vector<int> derived_values;
+
+    void rewind();
+public:
+    WalkState();
+
+    void set_track_landmarks(bool track) {track_landmarks = track;}
+
+    // Must be called whenever states that were passed to reset may have
+    // been destroyed or changed, as start is only compared by address.
+    void forget_start() {start = 0;}
+
+    // starts a walk from the given state
+    void reset(const State &start_state);
+    void apply(const Operator &op, AxiomEvaluator *axiom_eval);
+
+    // fingerprint of the variables, as State::get_hash would compute it
+    const StateHash &get_hash() const {return hash;}
+
+    State &get_state() {return state;}
+    const State &get_state() const {return state;}
+};
+
+#endif
@@ -1,14 +1,146 @@
 #include "walker.h"
+#include "mrw.h"
 #include "successor_generator.h"
 #include "math.h"
 #include "ff_heuristic.h"
 #include "landmarks_count_heuristic.h"
+#include "action_values.h"
+#include "memory_utils.h"
 #include <cstdlib>
 #include <climits>
 #include <cmath>
-#include <set>
+
+void EndpointTable::start_step(int num_walks) {
+	// at most half full, so probes stay short
+	int size = 16;
+	while(size < 2 * num_walks)
+		size *= 2;
+	if(entries.size() < size)
+		entries.assign(size, Entry());
+	step++;
+	num_entries = 0;
+	preferred.clear();
+}
+
+bool EndpointTable::lookup(const StateHash &key, int &value,
+		vector<const Operator *> &preferred_ops) const {
+	unsigned int mask = entries.size() - 1;
+	for(unsigned int i = key.index & mask; entries[i].step == step;
+			i = (i + 1) & mask) {
+		const Entry &entry = entries[i];
+		if(entry.key == key) {
+			value = entry.value;
+			preferred_ops.assign(preferred.begin() + entry.first_preferred,
+					preferred.begin() + entry.first_preferred + entry.num_preferred);
+			return true;
+		}
+	}
+	return false;
+}
+
+void EndpointTable::insert(const StateHash &key, int value,
+		const vector<const Operator *> &preferred_ops) {
+	// more endpoints than walks announced, later ones are just evaluated
+	if(2 * (num_entries + 1) > entries.size())
+		return;
+	unsigned int mask = entries.size() - 1;
+	unsigned int i = key.index & mask;
+	while(entries[i].step == step)
+		i = (i + 1) & mask;
+	Entry &entry = entries[i];
+	entry.key = key;
+	entry.step = step;
+	entry.value = value;
+	entry.first_preferred = preferred.size();
+	entry.num_preferred = preferred_ops.size();
+	preferred.insert(preferred.end(), preferred_ops.begin(), preferred_ops.end());
+	num_entries++;
+}
+
+void StepWeights::clear(int size) {
+	weights.assign(size, 0);
+	tree.resize(size + 1);
+}
+
+void StepWeights::build() {
+	int size = weights.size();
+	total = 0;
+	num_positive = 0;
+	tree[0] = 0;
+	for(int i = 1; i <= size; i++) {
+		tree[i] = weights[i - 1];
+		total += weights[i - 1];
+		if(weights[i - 1] > 0)
+			num_positive++;
+	}
+	// each node adds its sum to the next node that covers it
+	for(int i = 1; i <= size; i++) {
+		int parent = i + (i & -i);
+		if(parent <= size)
+			tree[parent] += tree[i];
+	}
+	top_bit = 1;
+	while(2 * top_bit <= size)
+		top_bit *= 2;
+}
+
+int StepWeights::find(double target) const {
+	assert(num_positive > 0);
+	int size = weights.size();
+	int pos = 0;
+	for(int bit = top_bit; bit != 0; bit /= 2) {
+		if(pos + bit <= size && tree[pos + bit] < target) {
+			pos += bit;
+			target -= tree[pos];
+		}
+	}
+	// rounding may leave pos at an operator without weight or past the
+	// last one, the nearest one with a weight is taken then
+	while(pos < size && weights[pos] <= 0)
+		pos++;
+	if(pos == size) {
+		do
+			pos--;
+		while(weights[pos] <= 0);
+	}
+	return pos;
+}
+
+void StepWeights::remove(int i) {
+	double weight = weights[i];
+	if(weight <= 0)
+		return;
+	weights[i] = 0;
+	num_positive--;
+	total = num_positive == 0 ? 0 : total - weight;
+	for(int j = i + 1; j < tree.size(); j += j & -j)
+		tree[j] -= weight;
+}
+
+Walker::Walker(AxiomEvaluator *a, RandomStream *r) : axiom_eval(a), rand_gen(r) {
+    dead_end_learner = 0;
+    if(g_dead_end_store != NULL)
+        dead_end_learner = new DeadEndLearner(g_dead_end_store);
+    dead_end_pruned = 0;
+    num_evaluated = 0;
+    num_duplicates = 0;
+    walk_function = 0;
+    walk_type = -1;
+    mha_endpoints = 0;
+    mda_walk = 0;
+    num_walks = 0;
+    num_allocating_walks = 0;
+    walk_allocations = 0;
+}
 
 Walker::~Walker(){
+    delete dead_end_learner;
+}
+
+int Walker::get_num_dead_ends_learned() const {
+    if(dead_end_learner == 0)
+        return 0;
+    return dead_end_learner->get_num_learned();
 }
 
 void Walker::init_info(){
@@ -20,9 +152,31 @@ void Walker::init_info(){
 	my_info.cost = 0;
 }
 
+// Returns the walk loop for the given walk type and bounding. Instantiating
+// them all here also provides them to random_walk.
+Walker::WalkFunction Walker::select_walk_function(int walk_type, int bounding) {
+    typedef MRW_Parameters P;
+    static const WalkFunction functions[3][3] = {
+        {&Walker::walk<P::PURE, P::NONE>, &Walker::walk<P::PURE, P::G_PRUNING>,
+         &Walker::walk<P::PURE, P::F_PRUNING>},
+        {&Walker::walk<P::MDA, P::NONE>, &Walker::walk<P::MDA, P::G_PRUNING>,
+         &Walker::walk<P::MDA, P::F_PRUNING>},
+        {&Walker::walk<P::MHA, P::NONE>, &Walker::walk<P::MHA, P::G_PRUNING>,
+         &Walker::walk<P::MHA, P::F_PRUNING>}
+    };
+    assert(walk_type >= 0 && walk_type < 3 && bounding >= 0 && bounding < 3);
+    return functions[walk_type][bounding];
+}
+
 void Walker::prepare_for_walks(MRW_Parameters& params, Heuristic *h) {
 
+    // what was learned in the last step goes to the other threads
+    if(g_action_values != NULL)
+        publish_action_values();
+
     walk_type = params.walk_type;
+    bounding = params.bounding;
+    walk_function = select_walk_function(walk_type, bounding);
 
     // initialize appropriate q value counters if necessary
     if(walk_type == MRW_Parameters::MDA) {
@@ -53,21 +207,108 @@ void Walker::prepare_for_walks(MRW_Parameters& params, Heuristic *h) {
             }
         }
     }
-    num_evaluated = 0;
+    // with all action values at 0, every weight is exp(0)
+    if(walk_type == MRW_Parameters::MDA || walk_type == MRW_Parameters::MHA) {
+        walk_temp = params.walk_bias_temp;
+        gibbs_weight.assign(g_operators.size(), 1.0);
+        gibbs_weight_stale.assign(g_operators.size(), false);
+    }
+    if(g_action_values != NULL)
+        take_action_values();
+    endpoints.start_step(params.num_walk);
 
     heuristic = h;
-    
+
+    // only MHA walks use the preferred operators of the endpoints
+    heuristic->set_cache_needs_preferred(walk_type == MRW_Parameters::MHA);
+
+    // the walks start from the states of the current trajectory, which may
+    // have changed since the last series
+    walk_state.forget_start();
+    walk_state.set_track_landmarks(heuristic->uses_reached_landmarks());
+
 }
-// TODO Probably shouldn't do it this way
-WalkInfo Walker::get_info(){
-    return my_info;
+template<int WalkType>
+inline const Operator* Walker::select_successor(
+        vector<const Operator *>& applicable_ops, const State &state,
+        bool debug){
+    if(WalkType == MRW_Parameters::PURE) {
+        while(true) {
+            const Operator *op = random_successor(applicable_ops);
+            if(op == 0 || dead_end_learner == 0 ||
+                    !g_dead_end_store->leads_to_dead_end(state, *op))
+                return op;
+
+            // reject the successor as a known dead end and select again
+            dead_end_pruned++;
+            for(int i = 0; i < applicable_ops.size(); i++) {
+                if(applicable_ops[i] == op) {
+                    applicable_ops[i] = applicable_ops.back();
+                    applicable_ops.pop_back();
+                    break;
+                }
+            }
+        }
+    }
+
+    if(WalkType == MRW_Parameters::MDA)
+        prepare_mda_step(applicable_ops, debug);
+    else
+        prepare_mha_step(applicable_ops);
+    while(true) {
+        int i;
+        if(WalkType == MRW_Parameters::MDA)
+            i = mda_successor(applicable_ops);
+        else
+            i = mha_successor(applicable_ops);
+        if(i == -1)
+            return 0;
+
+        const Operator *op = applicable_ops[i];
+        if(dead_end_learner == 0 ||
+                !g_dead_end_store->leads_to_dead_end(state, *op))
+            return op;
+
+        // reject the successor as a known dead end and select again without
+        // counting the rejected selection
+        dead_end_pruned++;
+        remove_step_op(i, op->get_op_index());
+    }
+}
+
+void Walker::take_info(WalkInfo &info) {
+    info.branching = my_info.branching;
+    info.length_offset = my_info.length_offset;
+    info.goal_visited = my_info.goal_visited;
+    info.value = my_info.value;
+    info.cost = my_info.cost;
+    // the walker keeps the old path of info for its next walk
+    info.path.swap(my_info.path);
 }
 	
-void Walker::random_walk(State initial_state, int length, MRW_Parameters& params,
+void Walker::random_walk(const State &initial_state, int length, MRW_Parameters& params,
 		int cost_bound, bool debug){
+	assert(params.walk_type == walk_type && params.bounding == bounding);
+	unsigned int allocations = get_thread_allocations();
+	(this->*walk_function)(initial_state, length, cost_bound, debug);
+	allocations = get_thread_allocations() - allocations;
+	num_walks++;
+	if(allocations != 0) {
+		num_allocating_walks++;
+		walk_allocations += allocations;
+	}
+}
+
+// The walk type and the bounding are template parameters, so the tests of
+// them fold away and the successor selection of the walk type is inlined
+// into the loop.
+template<int WalkType, int Bounding>
+void Walker::walk(const State &initial_state, int length, int cost_bound,
+		bool debug){
 	init_info();
 	int current_cost = 0;
-	State current_state = initial_state;
+	walk_state.reset(initial_state);
+	State &current_state = walk_state.get_state();
 	const Operator* op = 0;
 	int i = 0;
 
@@ -75,18 +316,18 @@ void Walker::random_walk(State initial_state, int length, MRW_Parameters& params
 	do{
 		if(debug)
 			current_state.dump();
-		vector<const Operator *> applicable_ops; 
+		vector<const Operator *> &applicable_ops = step_ops;
+		applicable_ops.clear();
 		g_successor_generator->generate_applicable_ops(current_state, applicable_ops);
 
 		my_info.branching += applicable_ops.size();
 		
+        // no successors at all, so try to learn why
+		if(applicable_ops.empty() && dead_end_learner != 0)
+			dead_end_learner->learn(current_state);
+
         // gets desired successor
-		if(params.walk_type == MRW_Parameters::PURE)
-			op = random_successor(applicable_ops);
-		else if (params.walk_type == MRW_Parameters::MDA)
-			op = mda_successor(applicable_ops, params, debug);
-		else if (params.walk_type == MRW_Parameters::MHA)
-			op = mha_successor(applicable_ops, params);
+		op = select_successor<WalkType>(applicable_ops, current_state, debug);
 
 		if(debug)
 			cout << " " <<  op->get_op_index() << " ";
@@ -96,7 +337,7 @@ void Walker::random_walk(State initial_state, int length, MRW_Parameters& params
 	    	my_info.value = MRW::A_LOT;
 	    	my_info.length_offset = length - i;
 	    	my_info.cost = current_cost;
-	    	if(params.walk_type == MRW_Parameters::MDA)
+	    	if(WalkType == MRW_Parameters::MDA)
 	    		update_mda_action_values();	    	
 	    	return;
 	    }
@@ -104,18 +345,18 @@ void Walker::random_walk(State initial_state, int length, MRW_Parameters& params
 	    current_cost += op->get_true_cost();
 
         // over g-cost bound
-		if (params.bounding != params.NONE && cost_bound != -1 && current_cost > cost_bound){
+		if (Bounding != MRW_Parameters::NONE && cost_bound != -1 && current_cost > cost_bound){
 	    	my_info.value = MRW::A_LOT;
 	    	my_info.length_offset = length - i;
 	    	my_info.cost = current_cost;
-	    	if(params.walk_type == MRW_Parameters::MDA)
+	    	if(WalkType == MRW_Parameters::MDA)
 	    		update_mda_action_values();
 	    	return;
 	    }
 
         // add new state to path
 		my_info.path.push_back(op);
-	    current_state = State(current_state, *op, axiom_eval);
+	    walk_state.apply(*op, axiom_eval);
 
         // found goal
 		if(check_goal(&current_state)){
@@ -130,22 +371,22 @@ void Walker::random_walk(State initial_state, int length, MRW_Parameters& params
 	if(debug)
 		cout << endl;
 
-	heuristic->set_recompute_heuristic(current_state);
-	heuristic->evaluate(current_state);
+	// with f-pruning, the heuristic only has to tell whether the endpoint
+	// fits into the remaining budget
+	int cutoff = Heuristic::NO_CUTOFF;
+	if(Bounding == MRW_Parameters::F_PRUNING && cost_bound != -1)
+		cutoff = cost_bound - current_cost;
+	int h = evaluate_endpoint(current_state, cutoff);
 	my_info.cost = current_cost;
 
-	num_evaluated ++;
-    // are at a dead end
-	if(heuristic->is_dead_end()){
+    // are at a dead end or over f-cost bound
+	if(h == Heuristic::DEAD_END || h == Heuristic::PRUNED){
 		my_info.value = MRW::A_LOT;
-		if(params.walk_type == MRW_Parameters::MDA)
+		if(WalkType == MRW_Parameters::MDA)
 			update_mda_action_values();
 		return;
 	}
 
-    // get heuristic value
-	int h = heuristic->get_heuristic();
-
     // is goal
 	if(h == 0 && check_goal(&current_state)){
 		
@@ -154,139 +395,204 @@ void Walker::random_walk(State initial_state, int length, MRW_Parameters& params
 		return;
 	}
 
-	if(params.bounding == params.F_PRUNING && cost_bound != -1 && (h + current_cost) > cost_bound){
-		my_info.value = MRW::A_LOT;
-    	if(params.walk_type == MRW_Parameters::MDA)
-    		update_mda_action_values();
-    	return;
-    }
-
 	my_info.value = h;
-	if(params.walk_type == MRW_Parameters::MHA){
-		vector<const Operator *> helpful_actions;
-		heuristic->get_preferred_operators(helpful_actions);
-		update_mha_action_values(helpful_actions);
-	}
+	if(WalkType == MRW_Parameters::MHA)
+		update_mha_action_values(endpoint_preferred);
 	
 	return;
 }
 
+// Returns the heuristic value of the endpoint of the current walk, DEAD_END
+// or PRUNED if it exceeds the cutoff. The preferred operators of an MHA walk
+// are left in endpoint_preferred.
+int Walker::evaluate_endpoint(const State &state, int cutoff) {
+	StateHash key = walk_state.get_hash();
+	if(heuristic->uses_reached_landmarks())
+		key.mix(state.get_reached_lms_hash());
+
+	int h;
+	if(endpoints.lookup(key, h, endpoint_preferred)) {
+		num_duplicates++;
+		if(h != Heuristic::DEAD_END && h > cutoff)
+			return Heuristic::PRUNED;
+		return h;
+	}
+
+	heuristic->set_recompute_heuristic(state);
+	heuristic->evaluate(state, 0, cutoff);
+	num_evaluated ++;
+	// the value of a pruned endpoint is not known, so it is not stored
+	if(heuristic->is_pruned())
+		return Heuristic::PRUNED;
+
+	endpoint_preferred.clear();
+	if(heuristic->is_dead_end()) {
+		if(dead_end_learner != 0)
+			dead_end_learner->learn(state);
+		h = Heuristic::DEAD_END;
+	} else {
+		h = heuristic->get_heuristic();
+		if(walk_type == MRW_Parameters::MHA)
+			heuristic->get_preferred_operators(endpoint_preferred);
+	}
+	endpoints.insert(key, h, endpoint_preferred);
+	return h;
+}
+
 const Operator* Walker::random_successor(vector<const Operator *>& applicable_ops){
     if(applicable_ops.size() == 0)
     	return 0;
-    int index = rand_gen->get_32bit_int() % applicable_ops.size();
+    int index = rand_gen->get_bounded(applicable_ops.size());
     const Operator* op = applicable_ops[index];
     return op;
 }
 
-const Operator* Walker::mha_successor(vector<const Operator *>& applicable_ops, MRW_Parameters& param){
-    if(applicable_ops.size() == 0)
-    	return 0;
-    vector<double> probs;
-    probs.resize(applicable_ops.size(), 0);
-    double sum = 0;
-    vector<int> unused_actions;
-    int non_zero_q = 0;
-    for (int i = 0; i < probs.size(); ++i) {
+void Walker::prepare_mha_step(const vector<const Operator *>& applicable_ops){
+    uniform_weights.clear(applicable_ops.size());
+    biased_weights.clear(applicable_ops.size());
+    num_unused = 0;
+    for (int i = 0; i < applicable_ops.size(); ++i) {
     	int index = applicable_ops[i]->get_op_index();
     	assert(index >= 0 && index < g_operators.size());
-    	
+
+    	uniform_weights.set(i, 1);
     	if(num[index] == 0)
-    		unused_actions.push_back(i);
-		if(Q_MHA[index] != 0){
-			double value = gibbs_func(Q_MHA[index], param.walk_bias_temp);
-	    		sum += value;
-			probs[i] = sum;
-			non_zero_q ++;
-		}
+    		num_unused ++;
+    	// operators with a zero value are never selected by their weight
+		if(Q_MHA[index] != 0)
+			biased_weights.set(i, gibbs_weight[index]);
 	}
-    if(unused_actions.size() == applicable_ops.size() || non_zero_q == 0){
-    	int index = rand_gen->get_32bit_int() % applicable_ops.size();
-    	int op_index = applicable_ops[index]->get_op_index();
-    	num[op_index] ++;
-    	return applicable_ops[index];
-    }
-    double coin = rand_gen->get_double(); 
-    int final_index = 0;
-    for (int i = 0; i < probs.size(); ++i) {
-    	if(coin <= (probs[i] / sum)){
-    		final_index = i;
-    		break;
-    	}
+    uniform_weights.build();
+    biased_weights.build();
+}
+
+int Walker::mha_successor(const vector<const Operator *>& applicable_ops){
+    int num_left = uniform_weights.get_num_positive();
+    if(num_left == 0)
+    	return -1;
+    int final_index;
+    if(num_unused == num_left || biased_weights.get_num_positive() == 0){
+    	// the k-th operator that is left
+    	int k = rand_gen->get_bounded(num_left);
+    	final_index = uniform_weights.find(k + 1);
+    } else {
+    	double coin = rand_gen->get_double();
+    	final_index = biased_weights.find(coin * biased_weights.get_total());
     }
     assert(final_index >= 0 && final_index < applicable_ops.size());
     int op_index = applicable_ops[final_index]->get_op_index();
-    //assert(Q_MHA[op_index] > 0);
     assert(op_index >= 0 && op_index < g_operators.size());
     num[op_index] ++;
-    return applicable_ops[final_index];
+    return final_index;
 }
 
-const Operator* Walker::mda_successor(vector<const Operator *>& applicable_ops, MRW_Parameters& param, bool debug){
-    if(applicable_ops.size() == 0)
-    	return 0;
-    vector<double> probs;
-    probs.resize(applicable_ops.size(), 0);
-    double sum = 0;
-    vector<int> unused_actions;
-    for (int i = 0; i < probs.size(); ++i) {
+void Walker::prepare_mda_step(const vector<const Operator *>& applicable_ops,
+		bool debug){
+    uniform_weights.clear(applicable_ops.size());
+    biased_weights.clear(applicable_ops.size());
+    for (int i = 0; i < applicable_ops.size(); ++i) {
     	int index = applicable_ops[i]->get_op_index();
     	assert(index >= 0 && index < g_operators.size());
 		if(debug){
 			cout << " -- " << index << " , " << Q_MDA[index] << " -- " << endl;
 		}
 
-    	if(num[index] != 0){
-	    	double value = gibbs_func(Q_MDA[index]/double(num[index]), param.walk_bias_temp);
-    		sum += value;
-
-			probs[i] = sum;
-    	}else{
-    		unused_actions.push_back(i);
-    	}
-    }
-    if(unused_actions.size() != 0){
-    	int index = rand_gen->get_32bit_int() % unused_actions.size();
-    	int op_index = applicable_ops[unused_actions[index]]->get_op_index();
-    	num[op_index] ++;
-    	return applicable_ops[unused_actions[index]];
+    	// unused operators are chosen among uniformly first
+    	if(num[index] != 0)
+    		biased_weights.set(i, get_mda_weight(index));
+    	else
+    		uniform_weights.set(i, 1);
     }
-    double coin = rand_gen->get_double(); 
-    int final_index = 0;
-    for (int i = 0; i < probs.size(); ++i) {
-    	if(coin <= (probs[i] / sum)){
-    		final_index = i;
-    		break;
-    	}
+    uniform_weights.build();
+    biased_weights.build();
+}
+
+int Walker::mda_successor(const vector<const Operator *>& applicable_ops){
+    int final_index;
+    if(uniform_weights.get_num_positive() != 0){
+    	// the k-th unused operator
+    	int k = rand_gen->get_bounded(uniform_weights.get_num_positive());
+    	final_index = uniform_weights.find(k + 1);
+    } else if(biased_weights.get_num_positive() != 0) {
+    	double coin = rand_gen->get_double();
+    	final_index = biased_weights.find(coin * biased_weights.get_total());
+    } else {
+    	return -1;
     }
     assert(final_index >= 0 && final_index < applicable_ops.size());
     int op_index = applicable_ops[final_index]->get_op_index();
     assert(op_index >= 0 && op_index < g_operators.size());
     num[op_index] ++;
-    return applicable_ops[final_index];
+    gibbs_weight_stale[op_index] = true;
+    return final_index;
+}
+
+void Walker::remove_step_op(int i, int op_index){
+    num[op_index]--;
+    gibbs_weight_stale[op_index] = true;
+    if(walk_type == MRW_Parameters::MHA && num[op_index] == 0)
+    	num_unused--;
+    uniform_weights.remove(i);
+    biased_weights.remove(i);
+}
+
+double Walker::get_mda_weight(int op_index){
+	if(gibbs_weight_stale[op_index]){
+		gibbs_weight[op_index] = gibbs_func(Q_MDA[op_index]/double(num[op_index]), walk_temp);
+		gibbs_weight_stale[op_index] = false;
+	}
+	return gibbs_weight[op_index];
 }
 
 void Walker::update_mda_action_values(){
-	set<int> added;
+	// an operator has been seen in this walk if it is marked with its number
+	mda_walk++;
+	if(mda_walk_of_op.size() != g_operators.size())
+		mda_walk_of_op.assign(g_operators.size(), 0);
 	for (int i = 0; i < my_info.path.size(); ++i) {
 		int op_index = my_info.path[i]->get_op_index();
 		assert(op_index >= 0 && op_index < g_operators.size());
-		set<int>::iterator it = added.find(op_index);
-		if(it == added.end()){
+		if(mda_walk_of_op[op_index] != mda_walk){
 			Q_MDA[op_index] --;			
-			added.insert(op_index);
+			mda_walk_of_op[op_index] = mda_walk;
 		}else{
 			assert(num[op_index] > 0);
 			num[op_index]--;
 		}
+		gibbs_weight_stale[op_index] = true;
 	}
 }
 
+void Walker::take_action_values() {
+    mha_endpoints = 0;
+    if(walk_type == MRW_Parameters::MDA) {
+        g_action_values->get_mda_values(Q_MDA, num);
+        prior_q = Q_MDA;
+        prior_num = num;
+        for(int i = 0; i < num.size(); i++)
+            gibbs_weight_stale[i] = num[i] != 0;
+    } else if(walk_type == MRW_Parameters::MHA) {
+        g_action_values->get_mha_values(Q_MHA);
+        prior_q = Q_MHA;
+        for(int i = 0; i < Q_MHA.size(); i++)
+            gibbs_weight[i] = gibbs_func(Q_MHA[i], walk_temp);
+    }
+}
+
+void Walker::publish_action_values() {
+    if(walk_type == MRW_Parameters::MDA)
+        g_action_values->add_mda_values(Q_MDA, prior_q, num, prior_num);
+    else if(walk_type == MRW_Parameters::MHA)
+        g_action_values->add_mha_values(Q_MHA, prior_q, mha_endpoints);
+}
+
 void Walker::update_mha_action_values(vector<const Operator *> &helpful_actions){
+	mha_endpoints++;
 	for (int i = 0; i < helpful_actions.size(); ++i) {
 		int op_index = helpful_actions[i]->get_op_index();
 		assert(op_index >= 0 && op_index < g_operators.size());
 		Q_MHA[op_index] += 1;
+		gibbs_weight[op_index] = gibbs_func(Q_MHA[op_index], walk_temp);
 	}
 }
 
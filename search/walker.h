@@ -7,9 +7,12 @@
 #include "state.h"
 #include "operator.h"
 #include "heuristic.h"
-#include "mrw.h"
+#include "mrw_parameters.h"
 #include "fd_ff_heuristic.h"
-#include "mtrand.h"
+#include "random_stream.h"
+#include "dead_end_store.h"
+#include "walk_state.h"
+#include "state_hash.h"
 
 using namespace std;
 
@@ -29,37 +32,170 @@ struct WalkInfo{
 	int cost;
 };
 
+/**
+ * The heuristic values of the walk endpoints of one MRW step. Short walks
+ * from the same trajectory node often end in the same state, and a repeated
+ * endpoint takes its value and preferred operators from here instead of
+ * being evaluated again.
+ *
+ * The table is addressed by the fingerprint that the walk state keeps up to
+ * date. Entries of earlier steps are told apart by the step number, so a new
+ * step does not have to clear the table.
+**/
+class EndpointTable {
+	struct Entry {
+		StateHash key;
+		int step;
+		int value;
+		// range of the preferred operators in EndpointTable::preferred
+		int first_preferred;
+		int num_preferred;
+		Entry() : step(0) {}
+	};
+	vector<Entry> entries;
+	vector<const Operator *> preferred;
+	int step;
+	int num_entries;
+public:
+	EndpointTable() : step(0), num_entries(0) {}
+	// empties the table for a step of the given number of walks
+	void start_step(int num_walks);
+	bool lookup(const StateHash &key, int &value,
+			vector<const Operator *> &preferred_ops) const;
+	void insert(const StateHash &key, int value,
+			const vector<const Operator *> &preferred_ops);
+};
+
+/**
+ * Weights of the operators applicable in one walk step, in a Fenwick tree.
+ * An operator is sampled in proportion to its weight, and a rejected one is
+ * removed, in O(log b) for b applicable operators. The tree is built in O(b)
+ * for each step, like the list of applicable operators itself.
+**/
+class StepWeights {
+	vector<double> weights;
+	// tree[i] is the sum of the weights from i - (i & -i) to i - 1
+	vector<double> tree;
+	double total;
+	int num_positive;
+	int top_bit;
+public:
+	StepWeights() : total(0), num_positive(0), top_bit(0) {}
+	// sets all weights to 0, the others are set before build()
+	void clear(int size);
+	void set(int i, double weight) {weights[i] = weight;}
+	void build();
+	double get_total() const {return total;}
+	int get_num_positive() const {return num_positive;}
+	// the first operator with a weight at which the sum of the weights up
+	// to it reaches target
+	int find(double target) const;
+	void remove(int i);
+};
+
 class Walker
 {
 	vector<int> num;
+
+	// Gibbs weights exp(Q / T) of the operators, computed when their action
+	// values change rather than at every step. The MDA weight of an operator
+	// also depends on how often it was selected, so it is only marked stale
+	// then and recomputed when it is needed next.
+	vector<double> gibbs_weight;
+	vector<bool> gibbs_weight_stale;
+	float walk_temp;
+
+	// The applicable operators of a step of a biased walk, by their Gibbs
+	// weights and by 1 for those that are chosen among uniformly. They are
+	// kept between steps.
+	StepWeights biased_weights;
+	StepWeights uniform_weights;
+	// MHA walks choose uniformly while all remaining operators are unused
+	int num_unused;
 	
 	WalkInfo my_info;
+	WalkState walk_state;
+	// applicable operators of the current step, kept between steps
+	vector<const Operator *> step_ops;
 	Heuristic* heuristic;
     int walk_type;
 
     AxiomEvaluator *axiom_eval;
 
-    MTRand_int32 *rand_gen;
+    RandomStream *rand_gen;
+
+    // learns dead ends into g_dead_end_store, NULL if no store is used
+    DeadEndLearner *dead_end_learner;
+    int dead_end_pruned;
+
+    EndpointTable endpoints;
+    // preferred operators of the last evaluated endpoint
+    vector<const Operator *> endpoint_preferred;
+    int num_duplicates;
+
+    // a walk loop, specialised for a walk type and bounding
+    typedef void (Walker::*WalkFunction)(const State &initial_state,
+            int length, int cost_bound, bool debug);
+    // the loop for the walk type and bounding of the current step
+    WalkFunction walk_function;
+    int bounding;
 
+    static WalkFunction select_walk_function(int walk_type, int bounding);
+    template<int WalkType, int Bounding>
+    void walk(const State &initial_state, int length, int cost_bound,
+            bool debug);
+    template<int WalkType>
+    const Operator* select_successor(vector<const Operator *>& applicable_ops,
+            const State &state, bool debug);
     const Operator* random_successor(vector<const Operator *>& applicable_ops);
-	const Operator* mha_successor(vector<const Operator *>& applicable_ops, MRW_Parameters& param);
-	const Operator* mda_successor(vector<const Operator *>& applicable_ops, MRW_Parameters& param, bool debug);
+	// The biased walks set up the weights of a step first. Their successor
+	// functions return an index into the applicable operators, or -1 if
+	// none is left.
+	void prepare_mha_step(const vector<const Operator *>& applicable_ops);
+	void prepare_mda_step(const vector<const Operator *>& applicable_ops,
+			bool debug);
+	int mha_successor(const vector<const Operator *>& applicable_ops);
+	int mda_successor(const vector<const Operator *>& applicable_ops);
+	void remove_step_op(int i, int op_index);
 	
+	int evaluate_endpoint(const State &state, int cutoff);
 	double gibbs_func(double avg, float temperature);
+	double get_mda_weight(int op_index);
 	void update_mda_action_values();
+	// for each operator the last walk whose MDA update counted it
+	vector<int> mda_walk_of_op;
+	int mda_walk;
 	void update_mha_action_values(vector<const Operator *> &helpful_actions);
+
+	// With g_action_values, the action values of a step start from those
+	// of all threads, and what the step changed is published after it.
+	vector<double> prior_q;
+	vector<int> prior_num;
+	int mha_endpoints;
+	void take_action_values();
+	void publish_action_values();
 public:
 	vector<double> Q_MHA;
 	vector<double> Q_MDA;
+	// endpoints evaluated by the heuristic, and those that were not as
+	// an earlier walk of the same step ended in the same state
 	int num_evaluated;
+	int get_num_duplicates() const {return num_duplicates;}
+
+	// All that a walk needs is allocated by the first walks, later ones
+	// should not allocate at all. These count the walks that did.
+	int num_walks;
+	int num_allocating_walks;
+	int walk_allocations;
 	
 	void dump_mha_scores();
-    Walker(AxiomEvaluator *a, MTRand_int32 *r): axiom_eval(a), rand_gen(r){}
+    Walker(AxiomEvaluator *a, RandomStream *r);
     void init_info();
 
-    WalkInfo get_info();
+    // moves the result of the last walk into info, without allocating
+    void take_info(WalkInfo &info);
 	
-    void random_walk(State initial_state, int length, MRW_Parameters& params, int cost_bound, bool debug);
+    void random_walk(const State &initial_state, int length, MRW_Parameters& params, int cost_bound, bool debug);
 	void op_info();
 
     /**
@@ -67,6 +203,11 @@ public:
      * be reused.
     **/ 
     void prepare_for_walks(MRW_Parameters& params, Heuristic *h);
+    // the state that the last walk started from has been changed
+    void forget_walk_start() {walk_state.forget_start();}
+
+    int get_num_dead_ends_learned() const;
+    int get_num_dead_end_pruned() const {return dead_end_pruned;}
 	virtual ~Walker();
 };
 